@@ -20,6 +20,14 @@ const config = yaml(read(path.resolve(__dirname, './config.yml')));
 let entries = '';
 
 function cfg_entry_text(obj, idx) {
+  // Arrays occupy `size` consequent addresses. Defaults are set in code.
+  if (obj.size) {
+    return `#define CFG_${obj.name.toUpperCase()}_ADDR ${idx}
+#define CFG_${obj.name.toUpperCase()}_SIZE ${obj.size}
+
+`;
+  }
+
   let val = (obj.default || 0.0).toString();
 
   // Force float reprezentation for C.
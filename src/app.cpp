@@ -69,8 +69,13 @@ void app_start()
 
     // Normal processing
 
-    speedController.in_knob = sensors.knob;
-    speedController.in_speed = sensors.speed;
+    speedController.in_knob = sensors.knob.value;
+    // Use fresh speed from current half-wave, if enougth data collected
+    speedController.in_speed = sensors.speed_live_confident ?
+      sensors.speed_live : sensors.speed;
+    speedController.in_speed_valid = sensors.speed_live_confident ||
+      sensors.speed_valid;
+    speedController.in_speed_updated = sensors.speed_updated;
 
     speedController.tick();
 
@@ -15,6 +15,13 @@
 // Currently driven by ADC for simplicity.
 #define APP_TICK_FREQUENCY 17857
 
+// PID iteration frequency, Hz (~ once per half-wave of 50Hz mains). PID
+// integrator has extended precision, so rate is not limited by fix16.
+// Affects Ki "scale" of PID. Knob is processed with the same rate.
+#ifndef APP_PID_FREQUENCY
+#define APP_PID_FREQUENCY 100
+#endif
+
 
 extern void app_start();
 
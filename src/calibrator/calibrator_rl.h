@@ -7,6 +7,7 @@
 #include <cmath>
 
 #include "../fix16_math/fix16_math.h"
+#include "../p2_quantile.h"
 
 #include "../sensors.h"
 #include "../triac_driver.h"
@@ -67,8 +68,8 @@ public:
         break;
       }
 
-      voltage_buffer[buffer_idx] = fix16_to_float(sensors.voltage);
-      current_buffer[buffer_idx] = fix16_to_float(sensors.current);
+      voltage_buffer[buffer_idx] = fix16_to_float(sensors.get_voltage());
+      current_buffer[buffer_idx] = fix16_to_float(sensors.get_current());
 
       buffer_idx++;
 
@@ -94,7 +95,7 @@ public:
 
       // Record current & emulate voltage
       voltage_buffer[buffer_idx] = - voltage_buffer[buffer_idx - zero_cross_down_offset];
-      current_buffer[buffer_idx] = fix16_to_float(sensors.current);
+      current_buffer[buffer_idx] = fix16_to_float(sensors.get_current());
 
       buffer_idx++;
 
@@ -120,7 +121,9 @@ private:
   uint32_t buffer_idx = 0;
   uint32_t zero_cross_down_offset = 0;
 
-  MedianIteratorTemplate<float, 32> median_filter;
+  // Median of inductance samples. Streaming, to use all samples of wave,
+  // not first N only.
+  P2Quantile<float> median_filter;
 
   enum State {
     INIT,
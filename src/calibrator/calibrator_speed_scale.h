@@ -3,8 +3,30 @@
 
 // Run motor at max speed and measure speed scaling factor.
 // Max speed should have 1.0 at sensorss output.
+//
+// Then run motor at several lower setpoints, to build speed curve for
+// low speeds. We have no tachometer, reference speed is taken from:
+//
+// - commutator ripple (SPEED_RIPPLE), if found in most of periods. It's
+//   independent from back-EMF, relative to ripple at max speed.
+// - mechanical power otherwise. Without load, motor power is spent on fan &
+//   friction, assumed to be ~ speed^3 (pure fan load):
+//
+//   speed = (P / P_max) ^ (1/3)
+//   P ~ back-EMF * current = R_ekv * current^2
+//
+//   Note, power is calculated from the same R_ekv, which the curve should
+//   correct. So the curve models fan load only, and can't fix errors from
+//   friction or brush drop at low speed.
+//
+// Measured (linear speed, real speed) pairs are interpolated to uniform grid
+// of Sensors speed curve.
+
+#include <algorithm>
+#include <cmath>
 
 #include "../fix16_math/fix16_math.h"
+#include "../p2_quantile.h"
 
 #include "../app.h"
 #include "../sensors.h"
@@ -14,6 +36,18 @@ extern Sensors sensors;
 extern TriacDriver triacDriver;
 
 constexpr int calibrator_motor_startup_ticks = 3 * APP_TICK_FREQUENCY;
+constexpr int calibrator_motor_settle_ticks = 1 * APP_TICK_FREQUENCY;
+
+// Speed samples (mains periods) to average for every point, ~ 1.3 sec.
+// Median is streaming, no memory cost.
+constexpr int calibrator_measure_periods = 64;
+
+// Setpoints for speed curve, from high to low
+static const fix16_t calibrator_sweep_setpoints[] = {
+  F16(0.8), F16(0.6), F16(0.45), F16(0.3), F16(0.2), F16(0.12)
+};
+constexpr int calibrator_sweep_points =
+  sizeof(calibrator_sweep_setpoints) / sizeof(calibrator_sweep_setpoints[0]);
 
 class CalibratorSpeedScale
 {
@@ -25,11 +59,14 @@ public:
     switch (state) {
 
     case INIT:
-      // Reset scaling factor
-      sensors.cfg_rekv_to_speed_factor = fix16_one;
+      // Reset scaling factor & speed curve
+      sensors.set_rekv_to_speed_factor(fix16_one);
+      sensors.cfg_speed_table.reset();
 
       max_speed = 0;
       median_filter.reset();
+      reset_power_measure();
+      reset_ripple_measure();
 
       set_state(START);
       break;
@@ -74,21 +111,68 @@ public:
       triacDriver.setpoint = fix16_one;
       triacDriver.tick();
 
+      power_measure_tick();
+
       // Measure speed once per wave.
       if (!sensors.zero_cross_up) break;
 
       // Collect data and count attempts
       median_filter.add(sensors.speed);
+      ripple_measure_period();
 
-      if (ticks_cnt++ < 32) break;
+      if (ticks_cnt++ < calibrator_measure_periods) break;
 
       // Save data to EEPROM and update sensors config
       eeprom_float_write(
         CFG_REKV_TO_SPEED_FACTOR_ADDR,
         fix16_to_float(median_filter.result())
       );
-      sensors.cfg_rekv_to_speed_factor = sensors.speed;
-      set_state(STOP);
+      sensors.set_rekv_to_speed_factor(median_filter.result());
+
+      // Max speed is 1.0 now, remember reference power
+      curve_x[0] = 1.0F;
+      curve_p[0] = (float)current_sq_sum;
+      curve_r[0] = ripple_measure_result();
+
+      sweep_idx = 0;
+      set_state(SWEEP_SETTLE);
+
+      break;
+
+    // Set next setpoint and wait until speed is stable
+    case SWEEP_SETTLE:
+      triacDriver.setpoint = calibrator_sweep_setpoints[sweep_idx];
+      triacDriver.tick();
+
+      if (ticks_cnt++ < calibrator_motor_settle_ticks) break;
+
+      median_filter.reset();
+      reset_power_measure();
+      reset_ripple_measure();
+      set_state(SWEEP_MEASURE);
+
+      break;
+
+    case SWEEP_MEASURE:
+      triacDriver.setpoint = calibrator_sweep_setpoints[sweep_idx];
+      triacDriver.tick();
+
+      power_measure_tick();
+
+      if (!sensors.zero_cross_up) break;
+
+      median_filter.add(sensors.speed);
+      ripple_measure_period();
+
+      if (ticks_cnt++ < calibrator_measure_periods) break;
+
+      sweep_idx++;
+      curve_x[sweep_idx] = fix16_to_float(median_filter.result());
+      curve_p[sweep_idx] = power_measure_result();
+      curve_r[sweep_idx] = ripple_measure_result();
+
+      if (sweep_idx < calibrator_sweep_points) set_state(SWEEP_SETTLE);
+      else set_state(STOP);
 
       break;
 
@@ -98,6 +182,8 @@ public:
       triacDriver.tick();
 
       if (ticks_cnt++ > 1 * APP_TICK_FREQUENCY) {
+        // That may take some time, but we don't care about triac now
+        process_curve();
         set_state(INIT);
         return true;
       }
@@ -115,6 +201,8 @@ private:
     START,
     WAIT_MAX,
     MEASURE,
+    SWEEP_SETTLE,
+    SWEEP_MEASURE,
     STOP
   } state = INIT;
 
@@ -122,13 +210,122 @@ private:
 
   int ticks_cnt = 0;
 
-  MedianIteratorTemplate<fix16_t, 32> median_filter;
+  P2Quantile<fix16_t> median_filter;
+
+  // Speed curve points: linear speed, relative mechanical power and speed
+  // by ripple (-1 if not found). First point is max speed.
+  float curve_x[calibrator_sweep_points + 1];
+  float curve_p[calibrator_sweep_points + 1];
+  float curve_r[calibrator_sweep_points + 1];
+  int sweep_idx = 0;
+
+  // Sum of current^2 (fix16) for power measure
+  int64_t current_sq_sum = 0;
+
+  // Speed by ripple, and number of periods where ripple was found
+  P2Quantile<fix16_t> ripple_filter;
+  int ripple_found = 0;
 
   void set_state(State st)
   {
     state = st;
     ticks_cnt = 0;
   }
+
+  void reset_power_measure()
+  {
+    current_sq_sum = 0;
+  }
+
+  void power_measure_tick()
+  {
+    fix16_t current = sensors.get_current();
+    current_sq_sum += fix16_mul(current, current);
+  }
+
+  void reset_ripple_measure()
+  {
+    ripple_filter.reset();
+    ripple_found = 0;
+  }
+
+  // Once per period. Always "not found" without SPEED_RIPPLE.
+  void ripple_measure_period()
+  {
+    if (sensors.speed_ripple == RIPPLE_NOT_FOUND) return;
+
+    ripple_filter.add(sensors.speed_ripple);
+    ripple_found++;
+  }
+
+  // Ripple is trusted, if found in most of periods
+  float ripple_measure_result()
+  {
+    if (ripple_found < calibrator_measure_periods / 2) return -1;
+
+    return fix16_to_float(ripple_filter.result());
+  }
+
+  // Mechanical power, in relative units: speed * current^2.
+  // Measurement length is the same for all points, no need to divide.
+  float power_measure_result()
+  {
+    return fix16_to_float(median_filter.result()) * (float)current_sq_sum;
+  }
+
+  // Convert measured points to speed curve and save to EEPROM
+  void process_curve()
+  {
+    // Linear speed => real speed pairs, sorted by linear speed
+    float x[calibrator_sweep_points + 2];
+    float y[calibrator_sweep_points + 2];
+    int order[calibrator_sweep_points + 1];
+
+    for (int i = 0; i <= calibrator_sweep_points; i++) order[i] = i;
+
+    std::sort(order, order + calibrator_sweep_points + 1, [this](int a, int b) {
+      return curve_x[a] < curve_x[b];
+    });
+
+    x[0] = 0;
+    y[0] = 0;
+
+    for (int i = 0; i <= calibrator_sweep_points; i++)
+    {
+      float p = std::max(curve_p[order[i]], 0.0F);
+
+      x[i + 1] = curve_x[order[i]];
+
+      // Ripple is independent reference, use it when possible
+      if (curve_r[order[i]] > 0 && curve_r[0] > 0) y[i + 1] = curve_r[order[i]] / curve_r[0];
+      else y[i + 1] = std::cbrt(p / curve_p[0]);
+    }
+
+    const int points = calibrator_sweep_points + 2;
+    int seg = 0;
+    // Sensors apply curve to median of linear speeds, that's valid for
+    // monotonic curve only. Noisy power measure can break it => clamp.
+    float y_prev = 0;
+
+    for (int i = 0; i < CFG_REKV_TO_SPEED_TABLE_SIZE; i++)
+    {
+      float xg = (float)i / (CFG_REKV_TO_SPEED_TABLE_SIZE - 1);
+
+      while (seg < points - 2 && x[seg + 1] < xg) seg++;
+
+      float dx = x[seg + 1] - x[seg];
+      float yg = (dx > 0) ?
+        y[seg] + (y[seg + 1] - y[seg]) * (xg - x[seg]) / dx :
+        y[seg + 1];
+
+      yg = std::max(yg, y_prev);
+      y_prev = yg;
+
+      eeprom_float_write(CFG_REKV_TO_SPEED_TABLE_ADDR + i, yg);
+    }
+
+    sensors.configure();
+  }
 };
 
 
@@ -4,7 +4,8 @@
 // Detects when user quickly dials knob 3 times. This sequence is used
 // to start calibration sequence.
 //
-// .tick() should be called with APP_TICK_FREQUENCY/sec, as everything else.
+// .tick() should be called with APP_TICK_FREQUENCY/sec, as everything else,
+// but does real work only when knob value is updated (at control rate).
 // It returns `true` when dials detected, and `false` in other cases.
 
 
@@ -16,13 +17,9 @@
 
 extern Sensors sensors;
 
-#define KNOB_TRESHOLD F16(0.05)
-
-#define IS_KNOB_LOW(val)  (val < KNOB_TRESHOLD)
-#define IS_KNOB_HIGH(val) (val >= KNOB_TRESHOLD)
-
-constexpr int knob_wait_min = APP_TICK_FREQUENCY * 0.2;
-constexpr int knob_wait_max = APP_TICK_FREQUENCY * 1.0;
+// Timings are in knob updates (APP_PID_FREQUENCY)
+constexpr int knob_wait_min = APP_PID_FREQUENCY * 0.2;
+constexpr int knob_wait_max = APP_PID_FREQUENCY * 1.0;
 
 
 class CalibratorWaitKnobDial
@@ -30,14 +27,17 @@ class CalibratorWaitKnobDial
 public:
 
   bool tick() {
-    fix16_t knob = sensors.knob;
+    const Knob &knob = sensors.knob;
+
+    // Nothing changes between knob updates
+    if (!knob.updated) return false;
 
     switch (state) {
 
     // First, check that knob is zero,
     // prior to start detect dial sequence
     case IDLE:
-      if (IS_KNOB_LOW(knob))
+      if (!knob.high)
       {
         // If knob is zero long enougth - go to 0 -> 1 edge detect
         ticks_cnt++;
@@ -53,10 +53,10 @@ public:
     // and increment dials
     case KNOB_UP_CHECK:
       // Knob and counters are 0 => we are just from IDLE state, do nothing,
-      if (IS_KNOB_LOW(knob) && ticks_cnt == 0) break;
+      if (!knob.high && ticks_cnt == 0) break;
 
       // Finally, knob is up => count time & reset state if too long
-      if (IS_KNOB_HIGH(knob))
+      if (!knob.edge_down)
       {
         ticks_cnt++;
         if (ticks_cnt > knob_wait_max) reset();
@@ -87,7 +87,7 @@ public:
 
     case KNOB_DOWN_CHECK:
       // Measure down state length and reset if too long
-      if (IS_KNOB_LOW(knob))
+      if (!knob.edge_up)
       {
         ticks_cnt++;
         if (ticks_cnt > knob_wait_max) reset();
@@ -39,5 +39,17 @@
 #define CFG_REKV_TO_SPEED_FACTOR_ADDR 11
 #define CFG_REKV_TO_SPEED_FACTOR_DEFAULT 450.0
 
+#define CFG_KNOB_TIME_CONSTANT_ADDR 12
+#define CFG_KNOB_TIME_CONSTANT_DEFAULT 0.02
+
+#define CFG_MOTOR_TIME_CONSTANT_ADDR 13
+#define CFG_MOTOR_TIME_CONSTANT_DEFAULT 0.3
+
+#define CFG_REKV_TO_SPEED_TABLE_ADDR 14
+#define CFG_REKV_TO_SPEED_TABLE_SIZE 9
+
+#define CFG_COMMUTATOR_RIPPLES_ADDR 23
+#define CFG_COMMUTATOR_RIPPLES_DEFAULT 12.0
+
 
 #endif
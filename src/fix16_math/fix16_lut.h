@@ -0,0 +1,69 @@
+#ifndef __FIX16_LUT__
+#define __FIX16_LUT__
+
+// Piecewise linear function, defined on uniform grid over [0.0..1.0] with
+// 2^SIZE_BITS intervals (2^SIZE_BITS + 1 breakpoints).
+//
+// Evaluation is branch-free (min/max only), without division. Negative input
+// is clamped to 0, input above 1.0 is extrapolated by last interval.
+
+#include <stdint.h>
+
+#include "libfixmath/fix16.h"
+
+
+template <int SIZE_BITS>
+class Fix16Lut
+{
+public:
+  enum { SIZE = (1 << SIZE_BITS) + 1 };
+
+  // Values at breakpoints 0, 1/2^SIZE_BITS, ..., 1.0
+  fix16_t table[SIZE];
+
+  Fix16Lut() { reset(); }
+
+  // Set identity function
+  void reset()
+  {
+    for (int i = 0; i < SIZE; i++) table[i] = (fix16_one >> SIZE_BITS) * i;
+  }
+
+  fix16_t eval(fix16_t x) const
+  {
+    const int shift = 16 - SIZE_BITS;
+
+    x = fix16_max(x, 0);
+
+    int idx = fix16_min(x >> shift, (1 << SIZE_BITS) - 1);
+    fix16_t frac = x - (idx << shift);
+    fix16_t y0 = table[idx];
+
+    return y0 + (fix16_t)(((int64_t)(table[idx + 1] - y0) * frac) >> shift);
+  }
+
+  // Inverse function, for non-decreasing table only. Linear search +
+  // division, don't use in hot path. Clamped to 0 below table, extrapolated
+  // by last interval above.
+  fix16_t eval_inverse(fix16_t y) const
+  {
+    const int shift = 16 - SIZE_BITS;
+
+    if (y <= table[0]) return 0;
+
+    int idx = 0;
+
+    while (idx < (1 << SIZE_BITS) - 1 && y >= table[idx + 1]) idx++;
+
+    fix16_t dy = table[idx + 1] - table[idx];
+
+    // Flat interval
+    if (dy <= 0) return (idx + 1) << shift;
+
+    return (idx << shift) +
+      (fix16_t)(((int64_t)(y - table[idx]) << shift) / dy);
+  }
+};
+
+
+#endif
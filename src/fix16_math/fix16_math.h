@@ -17,7 +17,7 @@ static inline fix16_t fix16_clamp_zero_one(fix16_t x)
 }
 
 
-#include "fix16_sinusize_table.h"
+#include "fix16_sinusize.h"
 
 // Convert linear requested "energy" to Sine-wave shift (used to
 // calculate triac opening phase)
@@ -26,13 +26,9 @@ static inline fix16_t fix16_clamp_zero_one(fix16_t x)
 //
 // NOTE: Don-t fogret to reverse range to get real triac opening phasephase
 //
-fix16_t fix16_sinusize(fix16_t x)
+static inline fix16_t fix16_sinusize(fix16_t x)
 {
-  fix16_t tmp = fix16_clamp_zero_one(x);
-
-  // 16 bits - fractional part. Need 9 bit for lookup
-  return (fix16_t)(sinusize_table[ tmp >> (16 - SINUSIZE_TABLE_SIZE_BITS) ]);
+  return fix16_sinusize_lut<SINUSIZE_TABLE_SIZE_BITS>(x);
 }
 
-
 #endif
@@ -0,0 +1,71 @@
+#ifndef __FIX_RECIP__
+#define __FIX_RECIP__
+
+// Cached reciprocal, to replace repeated `fix16_div(x, divisor)` with
+// multiply & shift.
+//
+// Divisor is normalized to [0.5..1) (shifted by leading zeros count), and
+// reciprocal is calculated with 32-bit division (16 bits precision) + one
+// Newton step (~30 bits). No 64-bit division, so `set()` is cheap too.
+//
+// Result is truncated (rounded to -inf). Error vs exact quotient is
+// 2 + |quotient| / 2^28 LSB max (< 10 LSB for whole fix16 range).
+
+#include <stdint.h>
+
+#include "libfixmath/fix16.h"
+
+
+class FixRecip
+{
+public:
+  FixRecip() {}
+  FixRecip(fix16_t divisor) { set(divisor); }
+
+  void set(fix16_t divisor)
+  {
+    negative = divisor < 0;
+
+    uint32_t d = negative ? -(uint32_t)divisor : divisor;
+
+    if (!d)
+    {
+      recip = 0;
+      return;
+    }
+
+    int lz = __builtin_clz(d);
+    uint32_t d_norm = d << lz;
+
+    // Initial estimate, Q31. Overestimates (divisor is truncated).
+    uint32_t r0 = (0xFFFFFFFFU / (d_norm >> 16)) << 15;
+
+    // Newton step: r = r0 * (2 - d * r0). Here d * r0 is Q63, close to 1.0
+    int64_t err = (int64_t)((uint64_t)d_norm * r0 - ((uint64_t)1 << 63));
+    int64_t r = r0 - (((int64_t)r0 * (err >> 32)) >> 31);
+
+    recip = (r > 0xFFFFFFFFLL) ? 0xFFFFFFFFU : (uint32_t)r;
+    shift = 47 - lz;
+  }
+
+  // x / divisor, fix16. Division by zero returns fix16_minimum (as
+  // fix16_div does), quotient overflow is not checked.
+  fix16_t div(fix16_t x) const
+  {
+    if (!recip) return fix16_minimum;
+
+    fix16_t result = (fix16_t)(((int64_t)x * recip) >> shift);
+
+    return negative ? -result : result;
+  }
+
+private:
+  // Normalized reciprocal (Q31, in [1.0..2.0)) and shift to apply after
+  // multiplication
+  uint32_t recip = 0;
+  int shift = 0;
+  bool negative = false;
+};
+
+
+#endif
@@ -0,0 +1,136 @@
+#ifndef __FIXED__
+#define __FIXED__
+
+// Signed fixed point number in Q<INT_BITS>.<FRAC_BITS> format (sign bit is
+// included in INT_BITS), stored in 32 bits. Fixed<16, 16> is fix16_t.
+//
+// - construction from constants is constexpr: Fixed<8, 24>(0.003)
+// - conversion between formats is a single shift, resolved at compile time
+// - mul/div use 64-bit intermediates, result has format of left operand
+//
+// Overflow is checked in host builds (FIXED_CHECK_OVERFLOW, enabled for unit
+// tests) and counted in `fixed_overflow_count()`. In firmware checks are
+// removed, and code is the same as hand-written shifts.
+
+#include <stdint.h>
+
+#include "libfixmath/fix16.h"
+
+#ifndef FIXED_CHECK_OVERFLOW
+#ifdef UNIT_TEST
+#define FIXED_CHECK_OVERFLOW 1
+#else
+#define FIXED_CHECK_OVERFLOW 0
+#endif
+#endif
+
+
+static inline uint32_t &fixed_overflow_count()
+{
+  static uint32_t count = 0;
+  return count;
+}
+
+// Truncate 64-bit intermediate to 32 bits
+static inline int32_t fixed_narrow(int64_t val)
+{
+#if FIXED_CHECK_OVERFLOW
+  if (val > INT32_MAX || val < INT32_MIN) fixed_overflow_count()++;
+#endif
+  return (int32_t)val;
+}
+
+
+template <int INT_BITS, int FRAC_BITS>
+class Fixed
+{
+  static_assert(INT_BITS + FRAC_BITS == 32, "Fixed: format should be 32 bits");
+  static_assert(INT_BITS >= 1 && FRAC_BITS >= 0, "Fixed: invalid format");
+
+public:
+  enum { INT = INT_BITS, FRAC = FRAC_BITS };
+
+  int32_t raw = 0;
+
+  constexpr Fixed() {}
+
+  // For constants only, rounds to nearest
+  explicit constexpr Fixed(double val)
+    : raw((int32_t)(val >= 0 ?
+        val * ((int64_t)1 << FRAC_BITS) + 0.5 :
+        val * ((int64_t)1 << FRAC_BITS) - 0.5)) {}
+
+  static constexpr Fixed from_raw(int32_t val)
+  {
+    Fixed result;
+    result.raw = val;
+    return result;
+  }
+
+  static Fixed from_int(int val)
+  {
+    return from_raw(fixed_narrow((int64_t)val << FRAC_BITS));
+  }
+
+  static Fixed from_fix16(fix16_t val)
+  {
+    return Fixed<16, 16>::from_raw(val).template to<INT_BITS, FRAC_BITS>();
+  }
+
+  fix16_t to_fix16() const { return to<16, 16>().raw; }
+
+  // Truncates towards -inf, as fix16_to_int with FIXMATH_NO_ROUNDING
+  int to_int() const { return raw >> FRAC_BITS; }
+
+  float to_float() const { return (float)raw / ((int64_t)1 << FRAC_BITS); }
+
+  // Convert to another format. Fraction bits are truncated, if new format
+  // has less.
+  template <int I2, int F2>
+  Fixed<I2, F2> to() const
+  {
+    if (F2 >= FRAC_BITS)
+    {
+      return Fixed<I2, F2>::from_raw(
+        fixed_narrow((int64_t)raw << (F2 >= FRAC_BITS ? F2 - FRAC_BITS : 0))
+      );
+    }
+    return Fixed<I2, F2>::from_raw(raw >> (F2 >= FRAC_BITS ? 0 : FRAC_BITS - F2));
+  }
+
+  Fixed operator+(Fixed b) const { return from_raw(fixed_narrow((int64_t)raw + b.raw)); }
+  Fixed operator-(Fixed b) const { return from_raw(fixed_narrow((int64_t)raw - b.raw)); }
+  Fixed operator-() const { return from_raw(fixed_narrow(-(int64_t)raw)); }
+
+  Fixed &operator+=(Fixed b) { return *this = *this + b; }
+  Fixed &operator-=(Fixed b) { return *this = *this - b; }
+
+  // Any format on the right, result in left format
+  template <int I2, int F2>
+  Fixed operator*(Fixed<I2, F2> b) const
+  {
+    return from_raw(fixed_narrow(((int64_t)raw * b.raw) >> F2));
+  }
+
+  template <int I2, int F2>
+  Fixed operator/(Fixed<I2, F2> b) const
+  {
+    return from_raw(fixed_narrow(((int64_t)raw << F2) / b.raw));
+  }
+
+  Fixed operator*(int b) const { return from_raw(fixed_narrow((int64_t)raw * b)); }
+  Fixed operator/(int b) const { return from_raw(raw / b); }
+
+  Fixed operator<<(int shift) const { return from_raw(fixed_narrow((int64_t)raw << shift)); }
+  Fixed operator>>(int shift) const { return from_raw(raw >> shift); }
+
+  bool operator==(Fixed b) const { return raw == b.raw; }
+  bool operator!=(Fixed b) const { return raw != b.raw; }
+  bool operator<(Fixed b) const { return raw < b.raw; }
+  bool operator>(Fixed b) const { return raw > b.raw; }
+  bool operator<=(Fixed b) const { return raw <= b.raw; }
+  bool operator>=(Fixed b) const { return raw >= b.raw; }
+};
+
+
+#endif
@@ -0,0 +1,107 @@
+#ifndef __KNOB__
+#define __KNOB__
+
+// Speed knob input stage.
+//
+// Knob is consumed at control rate only, so there is no reason to filter it
+// on every tick. Raw ADC samples are just accumulated, and once per
+// `knob_decimation` ticks we do the rest:
+//
+// - block mean of accumulated samples
+// - IIR smoother with configurable time constant
+// - quantization with hysteresis, to avoid output jitter
+// - edge events for "low" zone, used by calibration start detector
+
+#include "app.h"
+#include "fix16_math/fix16_math.h"
+
+constexpr int knob_decimation = APP_TICK_FREQUENCY / APP_PID_FREQUENCY;
+
+// Output is quantized to 1/1024 steps
+#define KNOB_QUANT_BITS 10
+#define KNOB_QUANT_STEP (fix16_one >> KNOB_QUANT_BITS)
+
+// Output is updated only when filtered value moves away for 2+ steps
+#define KNOB_HYSTERESIS (KNOB_QUANT_STEP * 2)
+
+// Bounds of "low" zone, for edge detection
+#define KNOB_TRESHOLD F16(0.05)
+#define KNOB_TRESHOLD_HYSTERESIS F16(0.01)
+
+
+class Knob
+{
+public:
+  // Knob position, normalized [0.0..1.0]. Updated at control rate.
+  fix16_t value = 0;
+
+  // Flags to simplify checks in other modules. true on ticks when new
+  // value is published / when knob leaves or enters "low" zone.
+  bool updated = false;
+  bool edge_up = false;
+  bool edge_down = false;
+
+  // true when knob is out of "low" zone
+  bool high = false;
+
+  // Set IIR smoother time constant, in seconds
+  void configure(float time_constant)
+  {
+    // Backward Euler discretization of 1st order filter
+    cfg_smooth_factor = fix16_from_float(
+      1.0F / (1.0F + time_constant * APP_PID_FREQUENCY)
+    );
+  }
+
+  // Should be called with APP_TICK_FREQUENCY.
+  // Input - sum of ADC_FETCH_PER_TICK raw 12-bit samples.
+  void tick(uint32_t adc_knob_sum)
+  {
+    updated = false;
+    edge_up = false;
+    edge_down = false;
+
+    adc_sum += adc_knob_sum;
+
+    if (++adc_sum_cnt < knob_decimation) return;
+
+    // 4096 - maximum value of 12-bit integer
+    // normalize to fix16_t[0.0..1.0]
+    fix16_t mean = (adc_sum << 4) / (knob_decimation * ADC_FETCH_PER_TICK);
+
+    adc_sum = 0;
+    adc_sum_cnt = 0;
+
+    filtered += fix16_mul(mean - filtered, cfg_smooth_factor);
+
+    if (fix16_abs(filtered - value) >= KNOB_HYSTERESIS)
+    {
+      // Round to nearest step
+      value = (filtered + (KNOB_QUANT_STEP >> 1)) & ~(KNOB_QUANT_STEP - 1);
+    }
+
+    if (!high && value >= KNOB_TRESHOLD + KNOB_TRESHOLD_HYSTERESIS)
+    {
+      high = true;
+      edge_up = true;
+    }
+    else if (high && value < KNOB_TRESHOLD - KNOB_TRESHOLD_HYSTERESIS)
+    {
+      high = false;
+      edge_down = true;
+    }
+
+    updated = true;
+  }
+
+private:
+  fix16_t cfg_smooth_factor = fix16_one;
+
+  uint32_t adc_sum = 0;
+  int adc_sum_cnt = 0;
+
+  fix16_t filtered = 0;
+};
+
+
+#endif
@@ -1,19 +1,51 @@
 #ifndef __MEDIAN_TEMPLATE__
 #define __MEDIAN_TEMPLATE__
 
-// Iteratively calculates median for up to SIZE data, and ignores the rest after
-// overflow.
+#include <algorithm>
+#include <stdint.h>
+#include <type_traits>
+
+#include "median_network.h"
+
+// Max SIZE to use sorting network instead of heaps (see below)
+#define MEDIAN_NETWORK_MAX_SIZE 16
+
+// What to do with new data, when SIZE values already collected:
+//
+// - IGNORE - drop. Result represents the first SIZE values only.
+// - RESERVOIR - replace random stored value with probability SIZE/n
+//   (reservoir sampling). Every value has equal chance to be kept.
+// - DECIMATE - drop every second stored value (by rank, so quantiles are
+//   kept), then accept every second new value. Repeats on next overflow
+//   with stride 4, 8, ... Deterministic, and data of the whole window is
+//   represented evenly. Work is split between overflowed `add()` (low half)
+//   and the next one (high half, always skipped by stride), to halve the
+//   worst case call cost. Cost is amortised only: these two calls still
+//   sort SIZE/2 values each, not suitable for hard per-call deadlines.
+enum MedianOverflow {
+  MEDIAN_OVERFLOW_IGNORE,
+  MEDIAN_OVERFLOW_RESERVOIR,
+  MEDIAN_OVERFLOW_DECIMATE
+};
+
+// Iteratively calculates median for up to SIZE data. Data after overflow are
+// processed according to POLICY (ignored by default).
 //
 // Useful for interrupt-driven data fill, to minimize possible locks.
-// Worst case ~ scan of 1/2 collected elements.
+// Insert is O(log n), result is O(1). With DECIMATE, overflow costs
+// 2 x O(n log n), in two calls (next `add()`, or first of `result()`,
+// `count()`, `spread()`).
 //
 // How it works (in general): https://stackoverflow.com/a/15319593/1031804
+//
+// - low half of data is kept in max-heap, high half - in min-heap
+// - heap sizes differ by 1 max, so median is on top of heaps
 
-template <typename T, int SIZE>
-class MedianIteratorTemplate {
+template <typename T, int SIZE, MedianOverflow POLICY = MEDIAN_OVERFLOW_IGNORE>
+class MedianHeapTemplate {
 
 public:
-  MedianIteratorTemplate() {
+  MedianHeapTemplate() {
     reset();
   }
 
@@ -21,156 +53,275 @@ public:
   {
     heap_lo_len = 0;
     heap_hi_len = 0;
-    heap_lo_max_idx = 0;
-    heap_hi_min_idx = 0;
+    seen = 0;
+    stride = 1;
+    skip = 0;
+    decimate_pending = false;
   }
 
   T result()
   {
+    if (decimate_pending) decimate_finish();
+
     int total_len = heap_lo_len + heap_hi_len;
 
-    // If not enougth data, create result manually
-    switch (total_len) {
-      case 0: return 0;
-      case 1: return heap_lo[0];
-      case 2: return (heap_lo[0] + heap_hi[0]) / 2;
-    }
+    if (total_len == 0) return 0;
 
     if (total_len & 0x01) {
-      return (heap_lo_len > heap_hi_len) ? heap_lo[heap_lo_max_idx] : heap_hi[heap_hi_min_idx];
+      return (heap_lo_len > heap_hi_len) ? heap_lo[0] : heap_hi[0];
     }
-    return (heap_lo[heap_lo_max_idx] + heap_hi[heap_hi_min_idx]) / 2;
+    return (heap_lo[0] + heap_hi[0]) / 2;
   }
 
-  void add(T val) {
-    // Process special cases
-    switch (heap_lo_len + heap_hi_len) {
-      case 0:
-        // First data => push to low heap
-        heap_lo[0] = val;
-        heap_lo_len = 1;
-        return;
+  int count()
+  {
+    if (decimate_pending) decimate_finish();
+
+    return heap_lo_len + heap_hi_len;
+  }
+
+  // Interquartile range (distance between medians of low & high halves).
+  // Not iterative, partially sorts copy of data - call once, when all
+  // data collected.
+  T spread()
+  {
+    if (decimate_pending) decimate_finish();
+
+    if (heap_lo_len + heap_hi_len < 2) return 0;
+
+    return middle(heap_hi, heap_hi_len) - middle(heap_lo, heap_lo_len);
+  }
+
+  void add(T val)
+  {
+    if (POLICY == MEDIAN_OVERFLOW_IGNORE)
+    {
+      // If all buffers occupied - stop accepting new data
+      if (heap_lo_len + heap_hi_len >= SIZE) return;
+    }
+    else if (POLICY == MEDIAN_OVERFLOW_RESERVOIR)
+    {
+      seen++;
 
-      case 1:
-        // Second data => low and high heaps should contain per 1 element each
-        // at the end. Reorder if needed.
-        if (val < heap_lo[0])
-        {
-          heap_hi[0] = heap_lo[0];
-          heap_lo[0] = val;
-        }
-        else heap_hi[0] = val;
-
-        heap_hi_len = 1;
+      if (heap_lo_len + heap_hi_len >= SIZE)
+      {
+        // Random index in [0..seen), without division
+        uint32_t idx = ((uint64_t)next_random() * seen) >> 32;
+        if (idx < SIZE) replace((int)idx, val);
         return;
+      }
+    }
+    else if (POLICY == MEDIAN_OVERFLOW_DECIMATE)
+    {
+      // Stride is >= 2 after overflow => this value is skipped anyway
+      if (decimate_pending) decimate_finish();
+
+      if (++skip < stride) return;
+      skip = 0;
 
-      case SIZE:
-        // If all buffers occupied - stop accepting new data
+      if (heap_lo_len + heap_hi_len >= SIZE)
+      {
+        decimate_start(val);
+        stride *= 2;
         return;
+      }
     }
 
-    // Now we have enougth to start with safe min/max searches.
-    T lo_max_val = heap_lo[heap_lo_max_idx];
-    T hi_min_val = heap_hi[heap_hi_min_idx];
+    insert(val);
+  }
+
+private:
+  T heap_lo[SIZE / 2 + (SIZE & 1)];
+  int heap_lo_len;
 
-    if (val < lo_max_val)
+  T heap_hi[SIZE / 2 + (SIZE & 1)];
+  int heap_hi_len;
+
+  // Overflow policy state: total values seen (reservoir), stride & skipped
+  // values counter (decimate), random generator state.
+  uint32_t seen;
+  int stride;
+  int skip;
+  uint32_t random_state = 2463534242U;
+
+  // Decimation in progress: low heap is done, high heap & insert of
+  // `decimate_val` are not.
+  bool decimate_pending;
+  T decimate_val;
+
+  void insert(T val)
+  {
+    if (heap_lo_len && val < heap_lo[0])
     {
       // New value must go to low heap
       if (heap_lo_len > heap_hi_len)
       {
         // Ups... curent size "too big" => transfer existing max to high heap
         // (and put new value to it's place)
-        heap_hi[heap_hi_len] = lo_max_val;
-        heap_hi_min_idx = heap_hi_len;
-        heap_hi_len++;
-
-        // Need refresh max after such update
-        heap_lo[heap_lo_max_idx] = val;
-        heap_lo_max_idx = get_heap_lo_max_idx();
-      }
-      else
-      {
-        // Just add value to low heap
-        heap_lo[heap_lo_len++] = val;
+        push(heap_hi, heap_hi_len, heap_lo[0], Greater());
+        heap_lo[0] = val;
+        sift_down(heap_lo, heap_lo_len, 0, Less());
       }
+      else push(heap_lo, heap_lo_len, val, Less());
     }
-    else if (val >= hi_min_val)
+    else if (heap_hi_len && val >= heap_hi[0])
     {
       // New value must go to high heap
       if (heap_hi_len > heap_lo_len)
       {
         // Ups... curent size "too big" => transfer existing min to low heap
         // (and put new value to it's place)
-        heap_lo[heap_lo_len] = hi_min_val;
-        heap_lo_max_idx = heap_lo_len;
-        heap_lo_len++;
-
-        // Need refresh min after such update
-        heap_hi[heap_hi_min_idx] = val;
-        heap_hi_min_idx = get_heap_hi_min_idx();
-      }
-      else
-      {
-        // Just add value to heap_hi
-        heap_hi[heap_hi_len++] = val;
+        push(heap_lo, heap_lo_len, heap_hi[0], Less());
+        heap_hi[0] = val;
+        sift_down(heap_hi, heap_hi_len, 0, Greater());
       }
+      else push(heap_hi, heap_hi_len, val, Greater());
     }
     else
     {
       // Value is somewhere "between" heaps => try push to lower heap,
       // if it's size is not too big
-      if (heap_lo_len > heap_hi_len)
-      {
-        // No space in low heap => push to high one
-        heap_hi[heap_hi_len] = val;
-        heap_hi_min_idx = heap_hi_len;
-        heap_hi_len++;
-      }
-      else
-      {
-        heap_lo[heap_lo_len] = val;
-        heap_lo_max_idx = heap_lo_len;
-        heap_lo_len++;
-      }
+      if (heap_lo_len > heap_hi_len) push(heap_hi, heap_hi_len, val, Greater());
+      else push(heap_lo, heap_lo_len, val, Less());
     }
   }
 
-private:
-  T heap_lo[SIZE / 2 + (SIZE & 1)];
-  int heap_lo_len;
-  int heap_lo_max_idx;
+  // xorshift32
+  uint32_t next_random()
+  {
+    random_state ^= random_state << 13;
+    random_state ^= random_state >> 17;
+    random_state ^= random_state << 5;
+    return random_state;
+  }
 
-  T heap_hi[SIZE / 2 + (SIZE & 1)];
-  int heap_hi_len;
-  int heap_hi_min_idx;
+  // Replace stored value by index (low heap first, then high heap). Value
+  // is restored in it's heap, then heap tops are swapped, if halves became
+  // mixed. Heap sizes are not changed.
+  void replace(int idx, T val)
+  {
+    if (idx < heap_lo_len) update_at(heap_lo, heap_lo_len, idx, val, Less());
+    else update_at(heap_hi, heap_hi_len, idx - heap_lo_len, val, Greater());
+
+    if (heap_lo[0] > heap_hi[0])
+    {
+      T tmp = heap_lo[0];
+      heap_lo[0] = heap_hi[0];
+      heap_hi[0] = tmp;
+      sift_down(heap_lo, heap_lo_len, 0, Less());
+      sift_down(heap_hi, heap_hi_len, 0, Greater());
+    }
+  }
+
+  // Keep every second value of each heap, by rank. Sorted arrays are valid
+  // heaps (descending - max-heap, ascending - min-heap), so sort, then
+  // compact. Median & quantiles are kept, heaps stay balanced.
+  //
+  // Heaps are unbalanced between start & finish, value is inserted on
+  // finish.
+  void decimate_start(T val)
+  {
+    std::sort(heap_lo, heap_lo + heap_lo_len, Greater());
+    heap_lo_len = compact(heap_lo, heap_lo_len);
 
-  int get_heap_lo_max_idx()
+    decimate_val = val;
+    decimate_pending = true;
+  }
+
+  void decimate_finish()
   {
-    int i, idx;
-    i = idx = heap_lo_len - 1;
-    T val = heap_lo[i];
+    std::sort(heap_hi, heap_hi + heap_hi_len, Less());
+    heap_hi_len = compact(heap_hi, heap_hi_len);
 
-    while (i--) {
-      int tmp = heap_lo[i];
-      if (tmp > val) { val = tmp; idx = i; }
+    decimate_pending = false;
+    insert(decimate_val);
+  }
+
+  static int compact(T *data, int len)
+  {
+    int new_len = (len + 1) / 2;
+    for (int i = 1; i < new_len; i++) data[i] = data[i * 2];
+    return new_len;
+  }
+
+  // Heap order: parent should not be "less" than child. `Less` gives
+  // max-heap, `Greater` - min-heap.
+  struct Less { bool operator()(const T &a, const T &b) const { return a < b; } };
+  struct Greater { bool operator()(const T &a, const T &b) const { return a > b; } };
+
+  template <typename Compare>
+  static void push(T *heap, int &len, T val, Compare less)
+  {
+    heap[len] = val;
+    sift_up(heap, len++, less);
+  }
+
+  template <typename Compare>
+  static void sift_up(T *heap, int i, Compare less)
+  {
+    T val = heap[i];
+
+    while (i > 0)
+    {
+      int parent = (i - 1) / 2;
+      if (!less(heap[parent], val)) break;
+      heap[i] = heap[parent];
+      i = parent;
     }
 
-    return idx;
+    heap[i] = val;
   }
 
-  int get_heap_hi_min_idx()
+  template <typename Compare>
+  static void sift_down(T *heap, int len, int i, Compare less)
   {
-    int i, idx;
-    i = idx = heap_hi_len - 1;
-    T val = heap_hi[i];
+    T val = heap[i];
 
-    while (i--) {
-      int tmp = heap_hi[i];
-      if (tmp < val) { val = tmp; idx = i; }
+    for (;;)
+    {
+      int child = i * 2 + 1;
+      if (child >= len) break;
+      if (child + 1 < len && less(heap[child], heap[child + 1])) child++;
+      if (!less(val, heap[child])) break;
+      heap[i] = heap[child];
+      i = child;
     }
 
-    return idx;
+    heap[i] = val;
+  }
+
+  template <typename Compare>
+  static void update_at(T *heap, int len, int i, T val, Compare less)
+  {
+    heap[i] = val;
+    sift_up(heap, i, less);
+    sift_down(heap, len, i, less);
+  }
+
+  static T middle(const T *src, int len)
+  {
+    T tmp[SIZE / 2 + (SIZE & 1)];
+    std::copy(src, src + len, tmp);
+
+    int mid = len / 2;
+    std::nth_element(tmp, tmp + mid, tmp + len);
+
+    if (len & 1) return tmp[mid];
+
+    // Even length - average with the biggest of lower part
+    return (*std::max_element(tmp, tmp + mid) + tmp[mid]) / 2;
   }
 };
 
+
+// Median for up to SIZE data. For small SIZE, sorting network (all work in
+// `result()`) is faster than heaps, and is selected automatically. Network
+// supports default overflow policy only.
+template <typename T, int SIZE, MedianOverflow POLICY = MEDIAN_OVERFLOW_IGNORE>
+using MedianIteratorTemplate = typename std::conditional<
+  (SIZE <= MEDIAN_NETWORK_MAX_SIZE && POLICY == MEDIAN_OVERFLOW_IGNORE),
+  MedianNetworkTemplate<T, SIZE>,
+  MedianHeapTemplate<T, SIZE, POLICY>
+>::type;
+
 #endif
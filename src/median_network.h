@@ -0,0 +1,87 @@
+#ifndef __MEDIAN_NETWORK_TEMPLATE__
+#define __MEDIAN_NETWORK_TEMPLATE__
+
+#include <limits>
+
+#include "sorting_network.h"
+
+// Median for up to SIZE data (the rest is ignored after overflow), with
+// sorting network. Same interface as heap-based median.
+//
+// `add()` only stores value, all work is done in `result()` - one pass of
+// branch-free network over SIZE elements. Not filled tail is padded with
+// max value, so the same network works for any data count. Data is sorted in
+// place (order of values does not matter for median), padding is overwritten
+// by next `add()`.
+//
+// Faster than heaps for small SIZE, see `MedianIteratorTemplate`.
+
+template <typename T, int SIZE>
+class MedianNetworkTemplate {
+
+public:
+  MedianNetworkTemplate() {
+    reset();
+  }
+
+  void reset()
+  {
+    len = 0;
+    sorted_ready = false;
+  }
+
+  int count() { return len; }
+
+  void add(T val)
+  {
+    if (len >= SIZE) return;
+
+    data[len++] = val;
+    sorted_ready = false;
+  }
+
+  T result()
+  {
+    if (len == 0) return 0;
+
+    sort();
+    return middle(data, len);
+  }
+
+  // Interquartile range (distance between medians of low & high halves)
+  T spread()
+  {
+    if (len < 2) return 0;
+
+    sort();
+
+    int lo_len = (len + 1) / 2;
+    return middle(data + lo_len, len - lo_len) - middle(data, lo_len);
+  }
+
+private:
+  T data[SIZE];
+  int len;
+  bool sorted_ready;
+
+  void sort()
+  {
+    if (sorted_ready) return;
+
+    for (int i = len; i < SIZE; i++) data[i] = std::numeric_limits<T>::max();
+
+    sorting_network::sort<T, SIZE>(data);
+    sorted_ready = true;
+  }
+
+  static T middle(const T *src, int src_len)
+  {
+    int mid = src_len / 2;
+
+    if (src_len & 1) return src[mid];
+
+    return (src[mid - 1] + src[mid]) / 2;
+  }
+};
+
+#endif
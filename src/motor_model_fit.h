@@ -0,0 +1,186 @@
+#ifndef __MOTOR_MODEL_FIT__
+#define __MOTOR_MODEL_FIT__
+
+// Online fit of motor model, every half-wave:
+//
+//   V = (R + R_ekv) * I + L * dI/dt
+//
+// R and R_ekv are not distinguishable inside of half-wave (both are
+// multiplied by I), so we fit R_total = R + R_ekv and L:
+//
+// - L changes slowly. It's fitted by recursive least squares, in
+//   information form: normal equation sums are accumulated per half-wave
+//   and added to history with exponential forgetting.
+// - R_total is solved for every half-wave separately, with known L.
+// - R is latched from R_total when motor is known to stand still
+//   (back-EMF is zero). So warm winding is picked up on every start,
+//   without calibration.
+// - While motor runs, R can be tracked only with independent speed
+//   measurement (commutator ripple, see RippleSpeedEstimator): it gives
+//   R_ekv reference, and R = R_total - R_ekv is filtered slowly (winding
+//   heats in minutes, ripple speed resolution is only ~ 1%). Without
+//   reference, R is updated on starts only.
+//
+// All sums are for raw ADC data (see RekvSumEstimator for details). Per tick
+// cost is 5 multiply-accumulate ops.
+
+#include "app.h"
+#include "fix16_math/fix16_math.h"
+
+// History forgetting factor is (1 - 2^-N)
+#define MOTOR_MODEL_FIT_FORGET_SHIFT 3
+
+// In-run R tracking filter, 1/2^N per update (~ 5 sec time constant at
+// 50 updates/sec)
+#define MOTOR_MODEL_FIT_R_TRACK_SHIFT 8
+
+
+class MotorModelFit
+{
+public:
+  // Fitted values, Ohm & Henry
+  fix16_t r = 0;
+  fix16_t r_total = 0;
+  fix16_t l = 0;
+
+  // Initial values (from calibration) & Kv/Ki - ratio of voltage & current
+  // ADC scales, Ohm. di_norm - scale of `di` input, if derivative filter
+  // is used.
+  void configure(fix16_t motor_resistance, fix16_t motor_inductance, fix16_t vi_ratio,
+    int di_norm = 1)
+  {
+    cfg_vi_ratio = vi_ratio;
+    cfg_di_norm = di_norm;
+    r = motor_resistance;
+    cfg_r = motor_resistance;
+    r_track = (int64_t)r << MOTOR_MODEL_FIT_R_TRACK_SHIFT;
+    l = motor_inductance;
+    // Fits fix16 for L up to 1.8H
+    l_freq = motor_inductance * APP_TICK_FREQUENCY / di_norm;
+
+    h_dd = h_vd = 0;
+    reset();
+  }
+
+  void reset()
+  {
+    sum_ii = sum_id = sum_dd = sum_vi = sum_vd = 0;
+  }
+
+  // Raw ADC data: voltage, current and current change since previous tick
+  void add(int32_t v, int32_t i, int32_t di)
+  {
+    sum_ii += i * i;
+    sum_id += i * di;
+    sum_dd += di * di;
+    sum_vi += v * i;
+    sum_vd += v * di;
+  }
+
+  // Should be called at the end of half-wave. Set `standstill` if motor is
+  // known to not rotate (to update R). `r_ekv_ref` - R_ekv by independent
+  // speed measurement, to track R while running. Negative if not available.
+  void update(bool standstill, fix16_t r_ekv_ref = F16(-1))
+  {
+    if (sum_ii == 0) return;
+
+    fit_inductance();
+
+    // Current is near zero => R_total does not fit fix16, reject half-wave
+    int64_t r_total_wide = solve_r_total();
+
+    if (r_total_wide > fix16_maximum || r_total_wide < fix16_minimum) return;
+
+    r_total = (fix16_t)r_total_wide;
+
+    if (standstill) r = r_total;
+    else if (r_ekv_ref >= 0)
+    {
+      // Accumulate with extra precision, single step is below fix16 LSB
+      fix16_t r_measured = fix16_clamp(r_total - r_ekv_ref, cfg_r / 2, cfg_r * 2);
+
+      r_track += (((int64_t)r_measured << MOTOR_MODEL_FIT_R_TRACK_SHIFT) - r_track)
+        >> MOTOR_MODEL_FIT_R_TRACK_SHIFT;
+      r = (fix16_t)(r_track >> MOTOR_MODEL_FIT_R_TRACK_SHIFT);
+      return;
+    }
+
+    r_track = (int64_t)r << MOTOR_MODEL_FIT_R_TRACK_SHIFT;
+  }
+
+  // R_ekv, Ohm
+  fix16_t result() { return r_total - r; }
+
+  // R_ekv for data collected so far in current half-wave, with known L.
+  // Does not update state.
+  fix16_t partial_result()
+  {
+    if (sum_ii == 0) return 0;
+
+    int64_t r_ekv = solve_r_total() - r;
+
+    if (r_ekv > fix16_maximum) return fix16_maximum;
+    if (r_ekv < fix16_minimum) return fix16_minimum;
+
+    return (fix16_t)r_ekv;
+  }
+
+private:
+  fix16_t cfg_vi_ratio = 0;
+  // R from calibration, to limit tracking
+  fix16_t cfg_r = 0;
+  // R filter state, scaled by 2^MOTOR_MODEL_FIT_R_TRACK_SHIFT
+  int64_t r_track = 0;
+  int cfg_di_norm = 1;
+  fix16_t l_freq = 0;
+
+  // Current half-wave sums
+  int64_t sum_ii, sum_id, sum_dd, sum_vi, sum_vd;
+  // History sums, with forgetting
+  int64_t h_dd = 0, h_vd = 0;
+
+  // R_total = (Kv/Ki * Σ v*i - L * F * Σ i*di) / Σ i^2, not limited to
+  // fix16 range
+  int64_t solve_r_total()
+  {
+    int64_t numerator = sum_vi * cfg_vi_ratio - sum_id * l_freq;
+    return numerator / sum_ii;
+  }
+
+  // Raw model is v = a * i + b * di, where b = L * F / (Kv/Ki) is the same
+  // for all half-waves, and a = R_total / (Kv/Ki) is not.
+  //
+  // To get rid of `a`, project out current from voltage & current derivative
+  // for each half-wave, and accumulate the rest:
+  //
+  //   Σdd' = Σdd - Σid * Σid / Σii
+  //   Σvd' = Σvd - Σvi * Σid / Σii
+  //
+  //   b = Σvd' / Σdd' (over history)
+  //
+  void fit_inductance()
+  {
+    fix16_t a = (sum_vi << 16) / sum_ii;
+    fix16_t c = (sum_id << 16) / sum_ii;
+
+    int64_t dd = sum_dd - ((c * sum_id) >> 16);
+    int64_t vd = sum_vd - ((a * sum_id) >> 16);
+
+    h_dd = h_dd - (h_dd >> MOTOR_MODEL_FIT_FORGET_SHIFT) + dd;
+    h_vd = h_vd - (h_vd >> MOTOR_MODEL_FIT_FORGET_SHIFT) + vd;
+
+    // Not enougth excitation, keep previous L
+    if (h_dd <= 0) return;
+
+    fix16_t b = (fix16_t)((h_vd << 16) / h_dd);
+
+    // Drop nonsense, if any
+    if (b <= 0) return;
+
+    l_freq = fix16_mul(b, cfg_vi_ratio);
+    l = l_freq * cfg_di_norm / APP_TICK_FREQUENCY;
+  }
+};
+
+
+#endif
@@ -0,0 +1,156 @@
+#ifndef __P2_QUANTILE__
+#define __P2_QUANTILE__
+
+// Streaming quantile estimator, P^2 algorithm:
+//
+// R. Jain, I. Chlamtac, "The P^2 algorithm for dynamic calculation of
+// quantiles and histograms without storing observations", 1985.
+//
+// Keeps 5 markers (min, p/2, p, (1+p)/2, max) and moves them to desired
+// positions with piecewise-parabolic interpolation. O(1) memory & update,
+// no limit on data count. Result is approximate, but converges quickly for
+// smooth distributions. For the first 5 samples result is exact.
+//
+// Math is done in float. Calculations are linear, so fix16_t works as is
+// (raw values are converted to float without scaling). Intended for
+// calibration, not for per-tick use.
+
+template <typename T>
+class P2Quantile {
+
+public:
+  // quantile - [0.0..1.0], 0.5 for median
+  P2Quantile(float quantile = 0.5F) : p(quantile)
+  {
+    reset();
+  }
+
+  void reset()
+  {
+    len = 0;
+  }
+
+  int count() { return len; }
+
+  void add(T val)
+  {
+    float x = (float)val;
+
+    // Collect first 5 samples, then init markers
+    if (len < 5)
+    {
+      q[len++] = x;
+
+      if (len == 5)
+      {
+        sort(q, 5);
+
+        for (int i = 0; i < 5; i++) n[i] = i;
+
+        np[0] = 0;
+        np[1] = 2 * p;
+        np[2] = 4 * p;
+        np[3] = 2 + 2 * p;
+        np[4] = 4;
+
+        dn[0] = 0;
+        dn[1] = p / 2;
+        dn[2] = p;
+        dn[3] = (1 + p) / 2;
+        dn[4] = 1;
+      }
+      return;
+    }
+
+    len++;
+
+    // Find cell k, where x falls, and update extremes
+    int k;
+
+    if (x < q[0]) { q[0] = x; k = 0; }
+    else if (x >= q[4]) { q[4] = x; k = 3; }
+    else
+    {
+      k = 0;
+      while (x >= q[k + 1]) k++;
+    }
+
+    for (int i = k + 1; i < 5; i++) n[i]++;
+    for (int i = 0; i < 5; i++) np[i] += dn[i];
+
+    // Adjust middle markers, if they are off desired positions
+    for (int i = 1; i <= 3; i++)
+    {
+      float d = np[i] - n[i];
+
+      if ((d >= 1 && n[i + 1] - n[i] > 1) || (d <= -1 && n[i - 1] - n[i] < -1))
+      {
+        int s = (d > 0) ? 1 : -1;
+        float qp = parabolic(i, s);
+
+        if (q[i - 1] < qp && qp < q[i + 1]) q[i] = qp;
+        else q[i] = linear(i, s);
+
+        n[i] += s;
+      }
+    }
+  }
+
+  T result()
+  {
+    if (len == 0) return 0;
+
+    if (len >= 5) return (T)q[2];
+
+    // Not enougth data for markers => exact value, interpolated between
+    // sorted samples
+    float tmp[5];
+    for (int i = 0; i < len; i++) tmp[i] = q[i];
+    sort(tmp, len);
+
+    float pos = p * (len - 1);
+    int idx = (int)pos;
+
+    if (idx >= len - 1) return (T)tmp[len - 1];
+
+    return (T)(tmp[idx] + (tmp[idx + 1] - tmp[idx]) * (pos - idx));
+  }
+
+private:
+  float p;
+  int len;
+
+  // Markers: heights, actual positions, desired positions & their increments
+  float q[5];
+  int n[5];
+  float np[5];
+  float dn[5];
+
+  // Insertion sort, for 5 elements max
+  static void sort(float *data, int data_len)
+  {
+    for (int i = 1; i < data_len; i++)
+    {
+      float val = data[i];
+      int j = i;
+
+      for (; j > 0 && data[j - 1] > val; j--) data[j] = data[j - 1];
+      data[j] = val;
+    }
+  }
+
+  float parabolic(int i, int s)
+  {
+    return q[i] + (float)s / (n[i + 1] - n[i - 1]) * (
+      (n[i] - n[i - 1] + s) * (q[i + 1] - q[i]) / (n[i + 1] - n[i]) +
+      (n[i + 1] - n[i] - s) * (q[i] - q[i - 1]) / (n[i] - n[i - 1])
+    );
+  }
+
+  float linear(int i, int s)
+  {
+    return q[i] + s * (q[i + s] - q[i]) / (n[i + s] - n[i]);
+  }
+};
+
+#endif
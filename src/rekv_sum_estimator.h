@@ -0,0 +1,83 @@
+#ifndef __REKV_SUM_ESTIMATOR__
+#define __REKV_SUM_ESTIMATOR__
+
+// Division-free R_ekv estimator.
+//
+// Instead of calculating R_ekv for every sample and taking median, accumulate
+// integer sums over measurement window, and solve least squares for R_ekv
+// once per half-wave:
+//
+//   V = (R + R_ekv) * I + L * dI/dt
+//
+//   R_ekv = (Σ V*I - L * Σ I*dI/dt) / Σ I^2 - R
+//
+// Sums are accumulated for raw ADC data. Voltage & current scales depend on
+// Vref the same way, so Vref cancels out:
+//
+//   V = Kv * v, I = Ki * i, dI/dt = Ki * di * APP_TICK_FREQUENCY
+//
+//   R_ekv = (Kv/Ki * Σ v*i - L * APP_TICK_FREQUENCY * Σ i*di) / Σ i^2 - R
+//
+// Per tick cost is 3 multiply-accumulate ops, one 64-bit division per
+// half-wave.
+
+#include "app.h"
+#include "fix16_math/fix16_math.h"
+
+
+class RekvSumEstimator
+{
+public:
+  // Kv/Ki - ratio of voltage & current ADC scales, Ohm.
+  // di_norm - scale of `di` input, if derivative filter is used.
+  void configure(fix16_t motor_resistance, fix16_t motor_inductance, fix16_t vi_ratio,
+    int di_norm = 1)
+  {
+    cfg_motor_resistance = motor_resistance;
+    cfg_vi_ratio = vi_ratio;
+    // Fits fix16 for L up to 1.8H
+    cfg_l_freq = motor_inductance * APP_TICK_FREQUENCY / di_norm;
+  }
+
+  void reset()
+  {
+    sum_vi = 0;
+    sum_ii = 0;
+    sum_idi = 0;
+    samples = 0;
+  }
+
+  // Raw ADC data: voltage, current and current change since previous tick
+  void add(int32_t v, int32_t i, int32_t di)
+  {
+    sum_vi += v * i;
+    sum_ii += i * i;
+    sum_idi += i * di;
+    samples++;
+  }
+
+  int count() { return samples; }
+
+  // R_ekv, Ohm
+  fix16_t result()
+  {
+    if (sum_ii == 0) return 0;
+
+    int64_t numerator = sum_vi * cfg_vi_ratio - sum_idi * cfg_l_freq;
+
+    return (fix16_t)(numerator / sum_ii) - cfg_motor_resistance;
+  }
+
+private:
+  fix16_t cfg_motor_resistance = 0;
+  fix16_t cfg_vi_ratio = 0;
+  fix16_t cfg_l_freq = 0;
+
+  int64_t sum_vi = 0;
+  int64_t sum_ii = 0;
+  int64_t sum_idi = 0;
+  int samples = 0;
+};
+
+
+#endif
@@ -0,0 +1,162 @@
+#ifndef __RIPPLE_SPEED_ESTIMATOR__
+#define __RIPPLE_SPEED_ESTIMATOR__
+
+// Speed estimator by commutator ripple.
+//
+// Every brush/segment commutation makes a small dip in motor current, so
+// current has ripple with frequency:
+//
+//   F = rpm / 60 * ripples_per_revolution
+//
+// For 30000 rpm and 12 ripples it's 6 kHz, below Nyquist at our tick
+// frequency. Ripple is searched with bank of Goertzel filters, placed
+// uniformly over speed range. Peak position is refined with parabolic
+// interpolation of neighbour bins.
+//
+// Goertzel mainlobe half-width (peak to first null) is F_tick / N, where N is
+// window length. Window is up to a quarter of 50 Hz mains period (89 ticks),
+// so mainlobe is ~ 200 Hz. Bins must be not more than that apart, or ripple
+// between bins is lost and interpolation has nothing to work with. If speed
+// range is too wide for the bank, it's narrowed from the low end.
+//
+// Low frequency current shape (half-wave "hump") is much bigger than ripple,
+// so filters are fed with current difference. That suppresses low frequencies
+// and keeps ripple.
+//
+// Independent from motor parameters, can be used to cross-check back-EMF
+// estimators. Window is short, bins are wide, so resolution is ~ 1% of
+// max speed (with interpolation, ripple at 5% of current).
+//
+// Cost: RIPPLE_BANK_SIZE multiplications (32x32 => 64) per tick, one 64-bit
+// division per half-wave.
+
+#include "app.h"
+#include "fix16_math/fix16_math.h"
+#include <math.h>
+
+#define RIPPLE_BANK_SIZE 28
+
+// Longest window, in ticks: second half of 50 Hz mains half-wave
+#define RIPPLE_WINDOW_MAX (APP_TICK_FREQUENCY / 200)
+
+// Bank coefficients precision
+#define RIPPLE_COEFF_BITS 14
+
+// Peak should be at least N times above average of bank, to be trusted
+#define RIPPLE_PEAK_RATIO 4
+
+// Min samples for result
+#define RIPPLE_MIN_SAMPLES 32
+
+// Result, when ripple not found
+#define RIPPLE_NOT_FOUND F16(-1)
+
+
+class RippleSpeedEstimator
+{
+public:
+  // ripple_max_freq - ripple frequency at max speed, Hz. Should be below
+  //   APP_TICK_FREQUENCY / 2
+  // min_speed - low bound of speed range, [0.0..1.0). Can be raised, to keep
+  //   bins within mainlobe
+  void configure(float ripple_max_freq, float min_speed)
+  {
+    float max_bin_step = (float)APP_TICK_FREQUENCY / RIPPLE_WINDOW_MAX / ripple_max_freq;
+
+    min_speed = fmaxf(min_speed, 1.0F - max_bin_step * (RIPPLE_BANK_SIZE - 1));
+
+    cfg_min_speed = fix16_from_float(min_speed);
+    cfg_bin_step = fix16_from_float((1.0F - min_speed) / (RIPPLE_BANK_SIZE - 1));
+
+    for (int k = 0; k < RIPPLE_BANK_SIZE; k++)
+    {
+      float freq = ripple_max_freq *
+        (min_speed + (1.0F - min_speed) * k / (RIPPLE_BANK_SIZE - 1));
+
+      coeff[k] = (int32_t)(2.0F * cosf(2.0F * (float)M_PI * freq / APP_TICK_FREQUENCY)
+        * (1 << RIPPLE_COEFF_BITS));
+    }
+
+    reset();
+  }
+
+  void reset()
+  {
+    for (int k = 0; k < RIPPLE_BANK_SIZE; k++) s1[k] = s2[k] = 0;
+    samples = 0;
+  }
+
+  // Raw ADC current. Should be called for continuous sequence of ticks.
+  void add(int32_t adc_current)
+  {
+    // First sample only initializes difference
+    if (samples++ == 0)
+    {
+      prev_current = adc_current;
+      return;
+    }
+
+    int32_t x = adc_current - prev_current;
+    prev_current = adc_current;
+
+    for (int k = 0; k < RIPPLE_BANK_SIZE; k++)
+    {
+      int32_t s = x + (int32_t)(((int64_t)coeff[k] * s1[k]) >> RIPPLE_COEFF_BITS) - s2[k];
+      s2[k] = s1[k];
+      s1[k] = s;
+    }
+  }
+
+  int count() { return samples; }
+
+  // Normalized speed [0.0..1.0] or RIPPLE_NOT_FOUND.
+  fix16_t result()
+  {
+    if (samples < RIPPLE_MIN_SAMPLES) return RIPPLE_NOT_FOUND;
+
+    int64_t power[RIPPLE_BANK_SIZE];
+    int64_t total = 0;
+    int peak = 0;
+
+    for (int k = 0; k < RIPPLE_BANK_SIZE; k++)
+    {
+      int64_t a = s1[k];
+      int64_t b = s2[k];
+
+      power[k] = a * a + b * b - (((coeff[k] * a) >> RIPPLE_COEFF_BITS) * b);
+      total += power[k];
+
+      if (power[k] > power[peak]) peak = k;
+    }
+
+    if (power[peak] * RIPPLE_BANK_SIZE < total * RIPPLE_PEAK_RATIO) return RIPPLE_NOT_FOUND;
+
+    // Parabolic interpolation, offset from peak bin in [-0.5..0.5]
+    fix16_t delta = 0;
+
+    if (peak > 0 && peak < RIPPLE_BANK_SIZE - 1)
+    {
+      int64_t left = power[peak - 1];
+      int64_t right = power[peak + 1];
+      int64_t den = 2 * (left - 2 * power[peak] + right);
+
+      if (den != 0) delta = (fix16_t)(((left - right) << 16) / den);
+    }
+
+    return cfg_min_speed + fix16_mul((peak << 16) + delta, cfg_bin_step);
+  }
+
+private:
+  int32_t coeff[RIPPLE_BANK_SIZE];
+  int32_t s1[RIPPLE_BANK_SIZE];
+  int32_t s2[RIPPLE_BANK_SIZE];
+
+  int32_t prev_current = 0;
+  int samples = 0;
+
+  fix16_t cfg_min_speed = 0;
+  fix16_t cfg_bin_step = 0;
+};
+
+
+#endif
@@ -0,0 +1,202 @@
+#ifndef __ROLLING_MEDIAN__
+#define __ROLLING_MEDIAN__
+
+#include <algorithm>
+
+// Median of last N samples (sliding window). Update is O(log N), result is
+// O(1). Unlike MedianIteratorTemplate, does not need reset - new samples
+// replace the oldest ones.
+//
+// How it works:
+//
+// - samples are stored in ring buffer
+// - low half of window is kept in max-heap, high half - in min-heap, as
+//   ring slot numbers. Low heap has the same size as high one, or +1.
+// - every slot knows it's position in heap, so when the oldest sample is
+//   replaced with new one, it's restored in place, without search.
+
+template <typename T, int N>
+class RollingMedian {
+
+public:
+  RollingMedian() {
+    reset();
+  }
+
+  void reset()
+  {
+    len = 0;
+    head = 0;
+    lo_len = 0;
+    hi_len = 0;
+  }
+
+  int count() { return len; }
+
+  T result()
+  {
+    if (len == 0) return 0;
+
+    if (len & 0x01) return data[lo[0]];
+
+    return (data[lo[0]] + data[hi[0]]) / 2;
+  }
+
+  // Interquartile range (distance between medians of low & high halves).
+  // Partially sorts copy of data - don't call on every tick.
+  T spread()
+  {
+    if (len < 2) return 0;
+
+    return middle(hi, hi_len) - middle(lo, lo_len);
+  }
+
+  void add(T val)
+  {
+    int slot = head;
+    head = (head + 1) % N;
+
+    data[slot] = val;
+
+    if (len < N)
+    {
+      len++;
+      insert(slot);
+      return;
+    }
+
+    // Window is full => slot had the oldest sample, and value changed in
+    // place. Restore heap order, then make sure halves are not mixed.
+    int p = pos[slot];
+
+    if (p < 0)
+    {
+      p = -p - 1;
+      if (!sift_up(lo, p, true)) sift_down(lo, lo_len, p, true);
+    }
+    else
+    {
+      if (!sift_up(hi, p, false)) sift_down(hi, hi_len, p, false);
+    }
+
+    if (hi_len && data[lo[0]] > data[hi[0]])
+    {
+      int tmp = lo[0];
+      lo[0] = hi[0];
+      hi[0] = tmp;
+      pos[lo[0]] = -1;
+      pos[hi[0]] = 0;
+      sift_down(lo, lo_len, 0, true);
+      sift_down(hi, hi_len, 0, false);
+    }
+  }
+
+private:
+  T data[N];
+
+  // Heaps of ring slots. Slot position is stored in `pos`: index in high
+  // heap, or (-1 - index) in low heap.
+  int lo[N / 2 + 1];
+  int hi[N / 2 + 1];
+  int pos[N];
+
+  int len;
+  int head;
+  int lo_len;
+  int hi_len;
+
+  // Heap order check: `a` can be parent of `b`
+  bool above(int a, int b, bool is_lo)
+  {
+    return is_lo ? data[a] > data[b] : data[a] < data[b];
+  }
+
+  void place(int *heap, int idx, int slot, bool is_lo)
+  {
+    heap[idx] = slot;
+    pos[slot] = is_lo ? -1 - idx : idx;
+  }
+
+  // Returns true if element moved
+  bool sift_up(int *heap, int idx, bool is_lo)
+  {
+    int slot = heap[idx];
+    int start = idx;
+
+    while (idx > 0)
+    {
+      int parent = (idx - 1) / 2;
+      if (!above(slot, heap[parent], is_lo)) break;
+      place(heap, idx, heap[parent], is_lo);
+      idx = parent;
+    }
+
+    place(heap, idx, slot, is_lo);
+    return idx != start;
+  }
+
+  void sift_down(int *heap, int heap_len, int idx, bool is_lo)
+  {
+    int slot = heap[idx];
+
+    for (;;)
+    {
+      int child = idx * 2 + 1;
+      if (child >= heap_len) break;
+      if (child + 1 < heap_len && above(heap[child + 1], heap[child], is_lo)) child++;
+      if (!above(heap[child], slot, is_lo)) break;
+      place(heap, idx, heap[child], is_lo);
+      idx = child;
+    }
+
+    place(heap, idx, slot, is_lo);
+  }
+
+  void push(int *heap, int &heap_len, int slot, bool is_lo)
+  {
+    place(heap, heap_len, slot, is_lo);
+    sift_up(heap, heap_len++, is_lo);
+  }
+
+  // Remove top and return it's slot
+  int pop(int *heap, int &heap_len, bool is_lo)
+  {
+    int top = heap[0];
+    heap_len--;
+
+    if (heap_len)
+    {
+      place(heap, 0, heap[heap_len], is_lo);
+      sift_down(heap, heap_len, 0, is_lo);
+    }
+
+    return top;
+  }
+
+  // Add new slot, while window is not full
+  void insert(int slot)
+  {
+    if (lo_len == 0 || !(data[slot] > data[lo[0]])) push(lo, lo_len, slot, true);
+    else push(hi, hi_len, slot, false);
+
+    // Rebalance, low heap should have the same size or +1
+    if (lo_len > hi_len + 1) push(hi, hi_len, pop(lo, lo_len, true), false);
+    else if (hi_len > lo_len) push(lo, lo_len, pop(hi, hi_len, false), true);
+  }
+
+  T middle(const int *heap, int heap_len)
+  {
+    T tmp[N / 2 + 1];
+    for (int i = 0; i < heap_len; i++) tmp[i] = data[heap[i]];
+
+    int mid = heap_len / 2;
+    std::nth_element(tmp, tmp + mid, tmp + heap_len);
+
+    if (heap_len & 1) return tmp[mid];
+
+    // Even length - average with the biggest of lower part
+    return (*std::max_element(tmp, tmp + mid) + tmp[mid]) / 2;
+  }
+};
+
+#endif
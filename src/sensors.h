@@ -6,9 +6,89 @@
 #include "eeprom_float.h"
 #include "config_map.h"
 #include "fix16_math/fix16_math.h"
+#include "fix16_math/fix16_lut.h"
+#include "fix16_math/fix_recip.h"
+#include "truncated_mean.h"
 #include "median.h"
+#include "rolling_median.h"
+#include "sg_derivative.h"
+#include "knob.h"
+#include "rekv_sum_estimator.h"
+#include "motor_model_fit.h"
+#include "speed_observer.h"
+#include "ripple_speed_estimator.h"
 #include "app.h"
 
+// Speed estimators. Select via build flags, for example:
+// -D SPEED_ESTIMATOR=SPEED_ESTIMATOR_REKV_SUMS
+//
+// - median of R_ekv, calculated for every tick in measurement window
+// - least squares over measurement window sums (see RekvSumEstimator)
+// - online fit of motor model, with R & L tracking (see MotorModelFit)
+#define SPEED_ESTIMATOR_MEDIAN 0
+#define SPEED_ESTIMATOR_REKV_SUMS 1
+#define SPEED_ESTIMATOR_MODEL_FIT 2
+
+#ifndef SPEED_ESTIMATOR
+#define SPEED_ESTIMATOR SPEED_ESTIMATOR_MEDIAN
+#endif
+
+// Median estimator only. Set to N > 0 to use median of last N samples,
+// instead of reset every half-wave. Filters continuously, and keeps data
+// between half-waves at low power.
+#ifndef SPEED_MEDIAN_ROLLING
+#define SPEED_MEDIAN_ROLLING 0
+#endif
+
+// Current derivative filter window (Savitzky-Golay), odd
+#define CURRENT_DERIVATIVE_SIZE 5
+
+// Speed curve size, 2^N intervals
+#define REKV_TO_SPEED_TABLE_BITS 3
+
+// Set to 1 to pass measured speed through SpeedObserver (fuses back-EMF
+// with mechanical model). Works with any estimator above.
+#ifndef SPEED_OBSERVER
+#define SPEED_OBSERVER 0
+#endif
+
+// Set to 1 to estimate speed by commutator ripple (see RippleSpeedEstimator),
+// in addition to back-EMF. Result is published as `speed_ripple`, to
+// cross-check or replace main one. Costs ~ 200 cycles per tick.
+#ifndef SPEED_RIPPLE
+#define SPEED_RIPPLE 0
+#endif
+
+// Live speed is refreshed every N samples in measurement window, and is
+// considered trustable after M samples.
+#define SPEED_LIVE_STRIDE 8
+#define SPEED_LIVE_MIN_SAMPLES 16
+
+// Measurement window tuning:
+// - skip N ticks after triac opening, until current & it's derivative settle
+// - accept samples with current above 1/2^SHIFT of previous half-wave peak
+//   (V / I is too noisy near zero current)
+// - need at least MIN_SAMPLES for speed update. If half-wave gave less (low
+//   power, triac opens late), data is accumulated for up to MAX_PERIODS
+//   half-waves.
+#define SPEED_WINDOW_SETTLE_TICKS 3
+#define SPEED_WINDOW_CURRENT_SHIFT 3
+#define SPEED_WINDOW_MIN_SAMPLES 16
+#define SPEED_WINDOW_MAX_PERIODS 4
+
+// Speed is considered valid, if collected from enougth samples, and (for
+// median) spread of samples is not too big. Spread limit is relative to
+// median, because samples are in R_ekv units (ohms) during speed scale
+// calibration. Near zero speed noise is bigger than median, so limit is not
+// less than MIN (in normalized speed).
+#define SPEED_VALID_MIN_SAMPLES 8
+#define SPEED_VALID_MAX_SPREAD_RATIO F16(0.5)
+#define SPEED_VALID_MAX_SPREAD_MIN F16(0.25)
+
+// If triac was not opened that long, motor is surely stopped.
+// In mains periods, ~ 2 sec.
+#define MOTOR_STOP_PERIODS 100
+
 /*
   Sensors data source:
 
@@ -21,16 +101,49 @@ class Sensors
 {
 public:
 
+  // Speed, updated once per mains period, at zero cross down
   fix16_t speed = 0;
-  fix16_t voltage = 0;
-  fix16_t current = 0;
-  fix16_t knob = 0; // Speed knob physical value, 0..1
+
+  // Speed estimate, published while measurement window is open (from data
+  // collected so far). Use it only when `speed_live_confident` is set,
+  // otherwise fall back to `speed`. Reset at zero cross down.
+  fix16_t speed_live = 0;
+  bool speed_live_confident = false;
+
+  // Number of samples, used for last `speed` update (may be collected in
+  // several half-waves at low power)
+  int speed_samples = 0;
+
+  // Number of samples, passed gates in last positive half-wave. Updated at
+  // zero cross down.
+  int half_wave_samples = 0;
+
+  // Interquartile range of samples behind last `speed` (median estimator
+  // only, 0 for others)
+  fix16_t speed_spread = 0;
+
+  // Last measurement is trustable. When not set, `speed` is not updated
+  // (previous value kept, or predicted by observer model), and control loop
+  // should not react.
+  bool speed_valid = true;
+
+  // Speed by commutator ripple, updated once per mains period.
+  // RIPPLE_NOT_FOUND (-1.0) if ripple not found (or SPEED_RIPPLE disabled).
+  fix16_t speed_ripple = RIPPLE_NOT_FOUND;
+
+  // Speed knob, processed at control rate
+  Knob knob;
 
   // Flags to simplify checks in other modules.
   // true on zero cross up/down, false in all other ticks
   bool zero_cross_up = false;
   bool zero_cross_down = false;
 
+  // true on ticks when new `speed` is published, false in all other ticks
+  // (`speed_live` refreshes don't set it - they reuse most of samples). To
+  // run control loop in sync.
+  bool speed_updated = false;
+
   // Config info
   fix16_t cfg_shunt_resistance_inv;
   fix16_t cfg_motor_resistance;
@@ -38,20 +151,30 @@ public:
   fix16_t cfg_motor_inductance;
   fix16_t cfg_rekv_to_speed_factor;
 
+  // Speed curve: maps linear speed (R_ekv / cfg_rekv_to_speed_factor)
+  // to real one. Identity by default.
+  Fix16Lut<REKV_TO_SPEED_TABLE_BITS> cfg_speed_table;
+
   // Input from triac driver to reflect triac state. Needed for speed measure
   // to drop noise. Autoupdated by triac driver.
   bool in_triac_on = false;
 
+  // Applied power [0.0..1.0], for speed observer. Autoupdated by triac driver.
+  fix16_t in_power = 0;
+
   // Should be called with 40kHz frequency
   void tick()
   {
     // Do preliminary filtering of raw data + normalize result
     fetch_adc_data();
 
-    if (prev_voltage == 0 && voltage > 0) zero_cross_up = true;
+    speed_updated = false;
+
+    // Zero cross is detected on raw data, conversion does not change sign
+    if (prev_adc_voltage == 0 && adc_voltage > 0) zero_cross_up = true;
     else zero_cross_up = false;
 
-    if (prev_voltage > 0 && voltage == 0) zero_cross_down = true;
+    if (prev_adc_voltage > 0 && adc_voltage == 0) zero_cross_down = true;
     else zero_cross_down = false;
 
     // Poor man zero cross check (both up and down)
@@ -62,17 +185,46 @@ public:
       once_zero_crossed = true;
 
       // If full half-period was counted at least once, save number of
-      // ticks in half-period
-      if (once_period_counted) period_in_ticks = phase_counter;
+      // ticks in half-period (and in full mains period - last 2 halves)
+      if (once_period_counted)
+      {
+        mains_period_in_ticks = period_in_ticks + phase_counter;
+        period_in_ticks = phase_counter;
+      }
 
       phase_counter = 0;
     }
 
+    voltage_sg.add(adc_voltage);
+    current_sg.add(adc_current);
+
     speed_tick();
 
     phase_counter++;
-    prev_voltage = voltage;
-    prev_current = current;
+    prev_adc_voltage = adc_voltage;
+  }
+
+  // Voltage (V) & current (A). Converted from filtered ADC data on first
+  // request and cached until next tick. Don't call those without need,
+  // conversion is not free.
+  fix16_t get_voltage()
+  {
+    if (!voltage_ready)
+    {
+      voltage = adc_to_voltage(adc_voltage);
+      voltage_ready = true;
+    }
+    return voltage;
+  }
+
+  fix16_t get_current()
+  {
+    if (!current_ready)
+    {
+      current = adc_to_current(adc_current);
+      current_ready = true;
+    }
+    return current;
   }
 
   // Load config from emulated EEPROM
@@ -98,11 +250,67 @@ public:
       eeprom_float_read(CFG_MOTOR_INDUCTANCE_ADDR, CFG_MOTOR_INDUCTANCE_DEFAULT)
     );
 
-    cfg_rekv_to_speed_factor = fix16_from_float(
+    set_rekv_to_speed_factor(fix16_from_float(
       eeprom_float_read(CFG_REKV_TO_SPEED_FACTOR_ADDR, CFG_REKV_TO_SPEED_FACTOR_DEFAULT)
+    ));
+
+    static_assert(
+      decltype(cfg_speed_table)::SIZE == CFG_REKV_TO_SPEED_TABLE_SIZE,
+      "Speed table size mismatch"
     );
 
+    for (int i = 0; i < CFG_REKV_TO_SPEED_TABLE_SIZE; i++)
+    {
+      cfg_speed_table.table[i] = fix16_from_float(eeprom_float_read(
+        CFG_REKV_TO_SPEED_TABLE_ADDR + i,
+        (float)i / (CFG_REKV_TO_SPEED_TABLE_SIZE - 1)
+      ));
+    }
+
+    // Ratio of voltage & current scales, to calculate R_ekv from raw ADC data.
+    // Voltage divider ratio => 201, shunt amplifier gain - 50.
+    float vi_ratio = (301.5F / 1.5F) *
+      eeprom_float_read(CFG_SHUNT_RESISTANCE_ADDR, CFG_SHUNT_RESISTANCE_DEFAULT)
+      * 50 / 1000;
+
+    rekv_sum_estimator.configure(
+      cfg_motor_resistance,
+      cfg_motor_inductance,
+      fix16_from_float(vi_ratio),
+      current_sg.NORM
+    );
+
+    motor_model_fit.configure(
+      cfg_motor_resistance,
+      cfg_motor_inductance,
+      fix16_from_float(vi_ratio),
+      current_sg.NORM
+    );
+
+    // Observer is updated once per mains period, measured in ticks
+    speed_observer.configure(
+      eeprom_float_read(CFG_MOTOR_TIME_CONSTANT_ADDR, CFG_MOTOR_TIME_CONSTANT_DEFAULT)
+    );
+
+#if SPEED_RIPPLE
+    float rpm_max = eeprom_float_read(CFG_RPM_MAX_ADDR, CFG_RPM_MAX_DEFAULT);
+
+    ripple_speed_estimator.configure(
+      rpm_max / 60 * eeprom_float_read(CFG_COMMUTATOR_RIPPLES_ADDR, CFG_COMMUTATOR_RIPPLES_DEFAULT),
+      eeprom_float_read(CFG_RPM_MIN_LIMIT_ADDR, CFG_RPM_MIN_LIMIT_DEFAULT) / rpm_max
+    );
+#endif
 
+    knob.configure(
+      eeprom_float_read(CFG_KNOB_TIME_CONSTANT_ADDR, CFG_KNOB_TIME_CONSTANT_DEFAULT)
+    );
+  }
+
+  // Update R_ekv to speed factor and it's cached reciprocal
+  void set_rekv_to_speed_factor(fix16_t factor)
+  {
+    cfg_rekv_to_speed_factor = factor;
+    cfg_rekv_to_speed_recip.set(factor);
   }
 
   // Split raw ADC data by separate buffers
@@ -124,104 +332,70 @@ private:
   uint16_t adc_knob_temp_buf[ADC_FETCH_PER_TICK];
   uint16_t adc_v_refin_temp_buf[ADC_FETCH_PER_TICK];
 
-  // 1. Calculate σ (discrete random variable)
-  // 2. Drop everything with deviation > 2σ and count mean for the rest.
-  //
-  // https://upload.wikimedia.org/wikipedia/commons/8/8c/Standard_deviation_diagram.svg
-  //
-  // For efficiensy, don't use root square (work with σ^2 instead)
-  //
-  // !!! count sould NOT be > 16
-  //
-  // src - circular buffer
-  // head - index of NEXT data to write
-  // count - number of elements BACK from head to process
-  // window - sigma multiplier (usually [1..2])
-  //
-  // Why this work? We use collision avoiding approach. Interrupt can happen,
-  // but we work with tail, and data is written to head. If bufer is big enougth,
-  // we have time to process tails until override.
-  //
-  uint32_t truncated_mean(uint16_t *src, int count, fix16_t window)
-  {
-    int idx = 0;
-
-    // Count mean & sigma in one pass
-    // https://en.wikipedia.org/wiki/Algorithms_for_calculating_variance
-    idx = count;
-    uint32_t s = 0;
-    uint32_t s2 = 0;
-    while (idx)
-    {
-      int val = src[--idx];
-      s += val;
-      s2 += val * val;
-    }
-
-    int mean = (s + (count >> 1)) / count;
-
-    int sigma_square = (s2 - (s * s / count)) / (count - 1);
-    // quick & dirty multiply to win^2, when win is in fix16 format.
-    // we suppose win is 1..2, and sigma^2 - 24 bits max
-    int sigma_win_square = ((((window >> 8) * (window >> 8)) >> 12) * sigma_square) >> 4;
-
-    // Drop big deviations and count mean for the rest
-    idx = count;
-    int s_mean_filtered = 0;
-    int s_mean_filtered_cnt = 0;
-
-    while (idx)
-    {
-      int val = src[--idx];
-
-      if ((mean - val) * (mean - val) < sigma_win_square)
-      {
-        s_mean_filtered += val;
-        s_mean_filtered_cnt++;
-      }
-    }
+  // Filtered raw ADC data (12 bits), updated every tick
+  uint16_t adc_voltage = 0;
+  uint16_t adc_current = 0;
+  uint16_t adc_v_refin = 0;
 
-    // Protection from zero div. Should never happen
-    if (!s_mean_filtered_cnt) return mean;
-
-    return (s_mean_filtered + (s_mean_filtered_cnt >> 1)) / s_mean_filtered_cnt;
-  }
+  // Cache of converted values, valid until next tick
+  fix16_t voltage = 0;
+  fix16_t current = 0;
+  fix16_t v_ref = 0;
+  bool voltage_ready = false;
+  bool current_ready = false;
+  bool v_ref_ready = false;
 
   void fetch_adc_data()
   {
     // Apply filters
-    uint16_t adc_voltage = truncated_mean(adc_voltage_temp_buf, ADC_FETCH_PER_TICK, F16(1.1));
-    uint16_t adc_current = truncated_mean(adc_current_temp_buf, ADC_FETCH_PER_TICK, F16(1.1));
-    uint16_t adc_knob = truncated_mean(adc_knob_temp_buf, ADC_FETCH_PER_TICK, F16(1.1));
-    uint16_t adc_v_refin =  truncated_mean(adc_v_refin_temp_buf, ADC_FETCH_PER_TICK, F16(1.1));
-
-    // Now process the rest...
+    adc_voltage = truncated_mean(adc_voltage_temp_buf, ADC_FETCH_PER_TICK, F16(1.1));
+    adc_current = truncated_mean(adc_current_temp_buf, ADC_FETCH_PER_TICK, F16(1.1));
+    adc_v_refin =  truncated_mean(adc_v_refin_temp_buf, ADC_FETCH_PER_TICK, F16(1.1));
 
-    // 4096 - maximum value of 12-bit integer
-    // normalize to fix16_t[0.0..1.0]
-    fix16_t knob_new = adc_knob << 4;
+    // Invalidate cached conversions
+    voltage_ready = false;
+    current_ready = false;
+    v_ref_ready = false;
 
-    // Use additional mean smoother for knob
-    knob = (knob * 15 + knob_new) >> 4;
+    // Knob is filtered at control rate, just feed raw data.
+    uint32_t adc_knob_sum = 0;
+    for (int i = 0; i < ADC_FETCH_PER_TICK; i++) adc_knob_sum += adc_knob_temp_buf[i];
 
+    knob.tick(adc_knob_sum);
+  }
 
-    // Vrefin - internal reference voltage, 1.2v
-    // Vref - ADC reference voltage, equal to ADC supply voltage (~ 3.3v)
-    // adc_vrefin = 1.2 / Vref * 4096
-    fix16_t v_ref = fix16_div(F16(1.2), adc_v_refin << 4);
+  fix16_t get_v_ref()
+  {
+    if (!v_ref_ready)
+    {
+      // Vrefin - internal reference voltage, 1.2v
+      // Vref - ADC reference voltage, equal to ADC supply voltage (~ 3.3v)
+      // adc_vrefin = 1.2 / Vref * 4096
+      v_ref = fix16_div(F16(1.2), adc_v_refin << 4);
+      v_ref_ready = true;
+    }
+    return v_ref;
+  }
 
+  // Convert raw ADC value (or difference of values) to amperes
+  fix16_t adc_to_current(int adc)
+  {
+    // 4096 - maximum value of 12-bit integer, normalize to fix16_t[0.0..1.0]
     // maximum ADC input voltage - Vref
     // current = adc_current_norm * v_ref / cfg_shunt_resistance
-    current = fix16_mul(
-      fix16_mul(adc_current << 4, cfg_shunt_resistance_inv),
-      v_ref
+    return fix16_mul(
+      fix16_mul(adc << 4, cfg_shunt_resistance_inv),
+      get_v_ref()
     );
+  }
 
+  // Convert raw ADC value to volts
+  fix16_t adc_to_voltage(int adc)
+  {
     // resistors in voltage divider - [ 2*150 kOhm, 1.5 kOhm ]
     // (divider ratio => 201)
     // voltage = adc_voltage * v_ref * (301.5 / 1.5);
-    voltage = fix16_mul(fix16_mul(adc_voltage << 4, v_ref), F16(301.5/1.5));
-
+    return fix16_mul(fix16_mul(adc << 4, get_v_ref()), F16(301.5/1.5));
   }
 
   // Holds number of tick when voltage crosses zero
@@ -229,15 +403,21 @@ private:
   // when voltage is negative
   uint32_t voltage_zero_cross_tick_count = 0;
 
-  // Previous iteration values. Used to detect zero cross.
-  fix16_t prev_voltage = 0;
-  fix16_t prev_current = 0;
+  // Previous iteration values (raw). Used to detect zero cross.
+  uint16_t prev_adc_voltage = 0;
+
+  // Last raw samples, for current derivative. Derivative is calculated for
+  // the middle of window, voltage ring is used to take aligned value.
+  SGDerivative<uint16_t, CURRENT_DERIVATIVE_SIZE> current_sg;
+  SGDerivative<uint16_t, CURRENT_DERIVATIVE_SIZE> voltage_sg;
 
   uint32_t phase_counter = 0; // increment every tick
   // Holds the number of ticks per half-period (between two zero crosses)
   // Will be near 400 for 50 Hz supply voltage or near 333.3333 for 60 Hz
   // Initial value -1 prevents triac from turning on during first period
   uint32_t period_in_ticks = 0;
+  // Full mains period (positive + negative half-waves), 0 until measured
+  uint32_t mains_period_in_ticks = 0;
 
 
   bool once_zero_crossed = false;
@@ -246,39 +426,263 @@ private:
   // Holds number of ticks since triac is on
   uint32_t triac_on_counter = 0;
 
-  MedianIteratorTemplate<fix16_t, 32> median_speed_filter;
+  // Current peak in this & previous half-wave, raw. For window gate.
+  uint16_t current_peak = 0;
+  uint16_t current_gate = 0;
+
+#if SPEED_MEDIAN_ROLLING
+  RollingMedian<fix16_t, SPEED_MEDIAN_ROLLING> median_speed_filter;
+#else
+  // Window can be longer than filter (up to ~ 90 samples at high power).
+  // Decimate on overflow, to use data of the whole window.
+  MedianIteratorTemplate<fix16_t, 32, MEDIAN_OVERFLOW_DECIMATE> median_speed_filter;
+#endif
+  RekvSumEstimator rekv_sum_estimator;
+  MotorModelFit motor_model_fit;
+  SpeedObserver speed_observer;
+  RippleSpeedEstimator ripple_speed_estimator;
+
+  // Number of samples in current measurement window, and number of
+  // half-waves it spans
+  int window_samples = 0;
+  int window_periods = 0;
+  // Samples in current half-wave
+  int half_wave_counter = 0;
+  // Triac was opened during measurement window. If so, but no samples
+  // passed the gates - measurement failed (it's not a stopped motor).
+  bool window_fired = false;
+
+  // To detect motor start from standstill (for motor model fit)
+  bool triac_fired = false;
+  bool standstill = false;
+  uint32_t triac_idle_periods = 0;
+
+  // 1/cfg_rekv_to_speed_factor
+  FixRecip cfg_rekv_to_speed_recip;
+
+  // Normalized speed without curve correction
+  fix16_t rekv_to_linear_speed(fix16_t r_ekv)
+  {
+    return cfg_rekv_to_speed_recip.div(r_ekv);
+  }
+
+  fix16_t rekv_to_speed(fix16_t r_ekv)
+  {
+    return cfg_speed_table.eval(rekv_to_linear_speed(r_ekv));
+  }
+
+  // Speed from data collected so far in measurement window
+  fix16_t partial_speed()
+  {
+#if SPEED_ESTIMATOR == SPEED_ESTIMATOR_REKV_SUMS
+    return rekv_to_speed(rekv_sum_estimator.result());
+#elif SPEED_ESTIMATOR == SPEED_ESTIMATOR_MODEL_FIT
+    return rekv_to_speed(motor_model_fit.partial_result());
+#else
+    return cfg_speed_table.eval(median_speed_filter.result());
+#endif
+  }
+
+  // Spread of median estimator samples is acceptable
+  bool spread_valid(fix16_t median, fix16_t spread)
+  {
+    fix16_t limit = fix16_mul(median, SPEED_VALID_MAX_SPREAD_RATIO);
+
+    if (limit < SPEED_VALID_MAX_SPREAD_MIN) limit = SPEED_VALID_MAX_SPREAD_MIN;
+
+    return spread <= limit;
+  }
 
   void speed_tick()
   {
     if (in_triac_on) triac_on_counter ++;
     else triac_on_counter = 0;
 
+    // Positive half-wave only, negative one is not measured
+    if (in_triac_on && adc_voltage > 0) window_fired = true;
+
+#if SPEED_ESTIMATOR == SPEED_ESTIMATOR_MODEL_FIT
+    if (in_triac_on) triac_fired = true;
+#endif
+
+    if (adc_current > current_peak) current_peak = adc_current;
+
     // We should measure speed when triac is on and data is trustable:
     //
-    // - skip couple of ticks after triac on
+    // - whole derivative filter window (CURRENT_DERIVATIVE_SIZE ticks back)
+    //   should be after current settled
+    // - second half of half-period only, to avoid measurement while negative
+    //   current from previous period flows
     // - skip everything after voltage become negative (become zero in our case)
-    // - skip everything before middle of half-period to avoid measurement while
-    //   negative current from previous period flows.
-    if ((triac_on_counter > 3) && (voltage > 0) && (phase_counter >= period_in_ticks / 2))
+    // - skip samples with too small current (ramp after triac opening and
+    //   tail at the end of half-wave)
+    //
+    // Conversion to volts & amperes is done only here, inside of
+    // measurement window.
+    if ((triac_on_counter > SPEED_WINDOW_SETTLE_TICKS + CURRENT_DERIVATIVE_SIZE - 1) &&
+        (phase_counter >= period_in_ticks / 2) &&
+        (adc_voltage > 0) &&
+        (current_sg.center() > current_gate))
     {
-      fix16_t di_dt = (current - prev_current) * APP_TICK_FREQUENCY;
-      fix16_t r_ekv = fix16_div(voltage, current)
+      // Current derivative (scaled by NORM) and data, aligned to it
+      int32_t adc_di = current_sg.result();
+      uint16_t adc_v = voltage_sg.center();
+      uint16_t adc_i = current_sg.center();
+
+#if SPEED_ESTIMATOR == SPEED_ESTIMATOR_REKV_SUMS
+      rekv_sum_estimator.add(adc_v, adc_i, adc_di);
+#elif SPEED_ESTIMATOR == SPEED_ESTIMATOR_MODEL_FIT
+      motor_model_fit.add(adc_v, adc_i, adc_di);
+#else
+      fix16_t volts = adc_to_voltage(adc_v);
+      fix16_t amps = adc_to_current(adc_i);
+      fix16_t di_dt = fix16_mul(
+        adc_to_current(adc_di),
+        F16((float)APP_TICK_FREQUENCY / current_sg.NORM)
+      );
+      // Both terms are divided by current => reciprocal is calculated once
+      FixRecip amps_recip(amps);
+      fix16_t r_ekv = amps_recip.div(volts)
         - cfg_motor_resistance
-        - fix16_div(fix16_mul(cfg_motor_inductance, di_dt), current);
+        - amps_recip.div(fix16_mul(cfg_motor_inductance, di_dt));
+
+      // Curve is monotonic, apply it to median only
+      median_speed_filter.add(rekv_to_linear_speed(r_ekv));
+#endif
+
+#if SPEED_RIPPLE
+      ripple_speed_estimator.add(adc_current);
+#endif
 
-      fix16_t _spd_single = fix16_div(r_ekv, cfg_rekv_to_speed_factor);
+      window_samples++;
+      half_wave_counter++;
 
-      median_speed_filter.add(_spd_single);
+      if (window_samples % SPEED_LIVE_STRIDE == 0)
+      {
+        speed_live = partial_speed();
+#if SPEED_OBSERVER
+        // Live speed would bypass observer fusion => use filtered `speed`
+        // only
+        speed_live_confident = false;
+#else
+        speed_live_confident = (window_samples >= SPEED_LIVE_MIN_SAMPLES);
+#if SPEED_ESTIMATOR == SPEED_ESTIMATOR_MEDIAN
+        // The same check as for `speed`. Spread is not cheap, skip if
+        // not needed.
+        speed_live_confident = speed_live_confident && spread_valid(
+          median_speed_filter.result(),
+          median_speed_filter.spread()
+        );
+#endif
+#endif
+      }
     }
 
     if (zero_cross_down)
     {
-      // Now we are at negative wave, update [normalized] speed
-      speed = median_speed_filter.result();
-      median_speed_filter.reset();
+      current_gate = current_peak >> SPEED_WINDOW_CURRENT_SHIFT;
+      current_peak = 0;
+
+      half_wave_samples = half_wave_counter;
+      half_wave_counter = 0;
+
+#if SPEED_RIPPLE
+      // Filters need continuous data, don't accumulate between half-waves
+      speed_ripple = ripple_speed_estimator.result();
+      ripple_speed_estimator.reset();
+#endif
+
+#if SPEED_ESTIMATOR == SPEED_ESTIMATOR_MODEL_FIT
+      // First half-wave after long pause => back-EMF is zero, update R
+      if (triac_fired && (triac_idle_periods >= MOTOR_STOP_PERIODS)) standstill = true;
+
+      if (triac_fired) triac_idle_periods = 0;
+      else triac_idle_periods++;
+      triac_fired = false;
+#endif
+
+      window_periods++;
+
+      // Too few samples (triac opens late) => continue collecting in next
+      // half-wave. Motor speed can't change much in such short time.
+      // Empty window without triac opening - update to drop speed.
+      if ((window_samples > 0 || window_fired) &&
+          window_samples < SPEED_WINDOW_MIN_SAMPLES &&
+          window_periods < SPEED_WINDOW_MAX_PERIODS) return;
+
+      speed_update();
     }
 
   }
+
+  // Now we are at negative wave, update [normalized] speed
+  void speed_update()
+  {
+    fix16_t new_speed;
+    bool spread_ok = true;
+    speed_spread = 0;
+
+#if SPEED_ESTIMATOR == SPEED_ESTIMATOR_REKV_SUMS
+    new_speed = rekv_to_speed(rekv_sum_estimator.result());
+    rekv_sum_estimator.reset();
+#elif SPEED_ESTIMATOR == SPEED_ESTIMATOR_MODEL_FIT
+#if SPEED_RIPPLE
+    // Speed by ripple is independent from R => use it as R_ekv reference,
+    // to track R while motor runs
+    fix16_t r_ekv_ref = speed_ripple == RIPPLE_NOT_FOUND ? F16(-1) : fix16_mul(
+      cfg_speed_table.eval_inverse(speed_ripple),
+      cfg_rekv_to_speed_factor
+    );
+    motor_model_fit.update(standstill, r_ekv_ref);
+#else
+    motor_model_fit.update(standstill);
+#endif
+    motor_model_fit.reset();
+    standstill = false;
+    new_speed = rekv_to_speed(motor_model_fit.result());
+#else
+#if SPEED_MEDIAN_ROLLING
+    // Triac was not opened => drop history, motor slows down.
+    if (!window_fired) median_speed_filter.reset();
+#endif
+    fix16_t median = median_speed_filter.result();
+
+    new_speed = cfg_speed_table.eval(median);
+    speed_spread = median_speed_filter.spread();
+    spread_ok = spread_valid(median, speed_spread);
+#if !SPEED_MEDIAN_ROLLING
+    median_speed_filter.reset();
+#endif
+#endif
+
+    // Triac was not opened => nothing to check, accept estimator's result
+    // as before (motor is stopped or slows down, and control loop should be
+    // able to start it). If triac was opened, but all samples were dropped
+    // by gates, result is garbage.
+    speed_valid = (!window_fired && window_samples == 0) ||
+      ((window_samples >= SPEED_VALID_MIN_SAMPLES) && spread_ok);
+
+#if SPEED_OBSERVER
+    // Window can span several mains periods (late triac opening), step
+    // model by whole elapsed time
+    int mains_period = mains_period_in_ticks ? mains_period_in_ticks : APP_TICK_FREQUENCY / 50;
+
+    // Don't correct with garbage, use model only
+    speed = speed_valid ?
+      speed_observer.update(in_power, new_speed, mains_period * window_periods) :
+      speed_observer.predict(in_power, mains_period * window_periods);
+#else
+    if (speed_valid) speed = new_speed;
+#endif
+
+    speed_samples = window_samples;
+    window_samples = 0;
+    window_periods = 0;
+    window_fired = false;
+    speed_live = speed;
+    speed_live_confident = false;
+    speed_updated = true;
+  }
 };
 
 
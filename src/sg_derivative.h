@@ -0,0 +1,72 @@
+#ifndef __SG_DERIVATIVE__
+#define __SG_DERIVATIVE__
+
+// Savitzky-Golay derivative on a ring buffer of last SIZE samples.
+//
+// Least squares fit of polynomial (1st or 2nd order - coefficients are
+// the same) to the window gives derivative at the middle sample:
+//
+//   dx/dt = Σ k * x[k] / NORM * sample_freq, k = -SIZE/2..SIZE/2
+//
+// result() returns integer Σ k * x[k], caller should apply NORM & frequency
+// (usually folded into other constants). Derivative is for the middle sample,
+// use center() to get the value, aligned in time.
+//
+// For white noise, variance is σ^2 / NORM vs 2σ^2 for 2-point difference
+// (2 * NORM times less, 20x for SIZE = 5).
+// Cost is SIZE multiply-accumulate ops per result.
+
+#include <stdint.h>
+
+
+template <typename T, int SIZE>
+class SGDerivative {
+  static_assert(SIZE >= 3 && (SIZE & 1), "SIZE should be odd and >= 3");
+
+public:
+  enum {
+    HALF = SIZE / 2,
+    // Σ k^2
+    NORM = HALF * (HALF + 1) * (2 * HALF + 1) / 3
+  };
+
+  SGDerivative() { reset(); }
+
+  void reset()
+  {
+    for (int i = 0; i < SIZE * 2; i++) buf[i] = 0;
+    head = 0;
+  }
+
+  void add(T val)
+  {
+    // Every sample is stored twice, to have window in continuous memory,
+    // without index wrap checks.
+    buf[head] = val;
+    buf[head + SIZE] = val;
+
+    if (++head >= SIZE) head = 0;
+  }
+
+  int32_t result() const
+  {
+    // Window from oldest to newest sample
+    const T *window = buf + head;
+    int32_t sum = 0;
+
+    // Coefficients are -HALF..HALF, folded to constants on loop unroll
+    for (int i = 0; i < SIZE; i++) sum += (i - HALF) * (int32_t)window[i];
+
+    return sum;
+  }
+
+  // Middle sample of window
+  T center() const { return buf[head + HALF]; }
+
+private:
+  T buf[SIZE * 2];
+  int head;
+};
+
+
+#endif
@@ -0,0 +1,95 @@
+#ifndef __SORTING_NETWORK__
+#define __SORTING_NETWORK__
+
+// Sorting network for fixed small N, generated at compile time.
+//
+// Network is Batcher's merge exchange (Knuth, TAOCP vol.3, 5.2.2, algorithm M),
+// works for any N. Comparators list is produced by constexpr functions and
+// expanded into straight code with constant indexes - no loops, no table, and
+// compare-exchange is branch-free (conditional moves).
+//
+// Comparators count: N=3 => 3, 5 => 9, 7 => 16, 9 => 26, 16 => 63.
+// Use for N up to ~ 16, code grows as N * log(N)^2.
+
+#include <stddef.h>
+#include <utility>
+
+namespace sorting_network {
+
+constexpr int log2_ceil(int n)
+{
+  int t = 0;
+  while ((1 << t) < n) t++;
+  return t;
+}
+
+// Walks comparators of algorithm M. Returns total count, or, if `want` >= 0,
+// first (side = 0) or second (side = 1) index of comparator number `want`.
+constexpr int walk(int n, int want, int side)
+{
+  if (n < 2) return 0;
+
+  int t = log2_ceil(n);
+  int k = 0;
+
+  for (int p = 1 << (t - 1); p > 0; p >>= 1)
+  {
+    int q = 1 << (t - 1);
+    int r = 0;
+    int d = p;
+
+    while (d > 0)
+    {
+      for (int i = 0; i < n - d; i++)
+      {
+        if ((i & p) != r) continue;
+
+        if (k == want) return side ? i + d : i;
+        k++;
+      }
+
+      d = q - p;
+      q >>= 1;
+      r = p;
+    }
+  }
+
+  return k;
+}
+
+constexpr int size(int n) { return walk(n, -1, 0); }
+
+template <typename T>
+inline void compare_exchange(T &a, T &b)
+{
+  T lo = (b < a) ? b : a;
+  T hi = (b < a) ? a : b;
+  a = lo;
+  b = hi;
+}
+
+// Indexes are template params, to make sure those are evaluated at compile
+// time, even without optimization.
+template <typename T, int A, int B>
+inline void compare_exchange_at(T *data)
+{
+  compare_exchange(data[A], data[B]);
+}
+
+template <typename T, int N, size_t... K>
+inline void apply(T *data, std::index_sequence<K...>)
+{
+  using expand = int[];
+  (void)expand{ 0, (compare_exchange_at<T, walk(N, K, 0), walk(N, K, 1)>(data), 0)... };
+}
+
+// Sort N elements in place, ascending
+template <typename T, int N>
+inline void sort(T *data)
+{
+  apply<T, N>(data, std::make_index_sequence<size(N)>());
+}
+
+} // namespace sorting_network
+
+#endif
@@ -6,13 +6,28 @@
 #include "eeprom_float.h"
 #include "config_map.h"
 #include "fix16_math/fix16_math.h"
+#include "fix16_math/fixed.h"
 
-// PID iteration frequency, Hz. To fit math in fix16 without overflow.
-// Affects Ki "scale" of PID
-#define APP_PID_FREQUENCY 40
+constexpr int freq_divisor = APP_TICK_FREQUENCY / APP_PID_FREQUENCY;
 
+// PID integrator & Ki format. Ki is divided by PID frequency, and at high
+// rate increments become too small for fix16 (Ki = 1/3s at 100Hz is ~ 0.0033,
+// and errors below ~ 0.5% are lost completely). 24 fractional bits keep
+// steady state the same at any rate.
+typedef Fixed<8, 24> pid_integral_t;
+
+// Set to 1 to run PID once per fresh speed sample (`in_speed_updated`),
+// instead of fixed APP_PID_FREQUENCY. No stale data & no beats between
+// PID and speed updates. Integrator adds previous divergence (it was held
+// on output all that time), scaled by ticks elapsed since previous
+// iteration.
+#ifndef SPEED_PID_SYNC
+#define SPEED_PID_SYNC 0
+#endif
 
-constexpr int freq_divisor = APP_TICK_FREQUENCY / APP_PID_FREQUENCY;
+// Max interval, used for integrator in sync mode (~ 0.1s). Limits
+// integrator jump, if speed updates were paused.
+#define SPEED_PID_SYNC_MAX_TICKS (APP_TICK_FREQUENCY / 10)
 
 
 class SpeedController
@@ -21,6 +36,8 @@ public:
   // Inputs
   fix16_t in_knob = 0;  // Knob position [0.0..1.0]
   fix16_t in_speed = 0; // Measured speed [0.0..1.0]
+  bool in_speed_valid = true; // If not set, speed PID holds it's state
+  bool in_speed_updated = false; // New speed sample (for SPEED_PID_SYNC)
 
   // Output power [0..1] for triac control
   fix16_t out_power = 0;
@@ -35,8 +52,14 @@ public:
   //
   void tick()
   {
-    // Downscale input frequency to avoid fixed poind overflow.
-    // 40000Hz => 40Hz
+#if SPEED_PID_SYNC
+    // Run on fresh speed only, remember time since previous run
+    if (ticks_elapsed < SPEED_PID_SYNC_MAX_TICKS) ticks_elapsed++;
+
+    if (!in_speed_updated) return;
+#else
+    // Downscale input frequency to PID rate.
+    // 17857Hz => 100Hz
 
     if (tick_freq_divide_counter >= freq_divisor) tick_freq_divide_counter = 0;
 
@@ -46,11 +69,14 @@ public:
     }
 
     tick_freq_divide_counter++;
+#endif
 
 
     knob_normalized = normalize_knob(in_knob);
 
-    if (!limiter_active)
+    // Don't react on garbage speed data. Hold output until next good
+    // measurement.
+    if (!limiter_active && in_speed_valid)
     {
       pid_speed_out = speed_pid_tick();
     }
@@ -63,7 +89,9 @@ public:
       {
         // Recalculate `pid_speed_integral` to ensure smooth output change
         // after switch to normal mode
-        pid_speed_integral = pid_speed_out - fix16_mul((knob_normalized - in_speed), cfg_pid_p);
+        pid_speed_integral = pid_integral_t::from_fix16(
+          pid_speed_out - fix16_mul((knob_normalized - in_speed), cfg_pid_p)
+        );
         limiter_active = false;
       }
       out_power = pid_speed_out;
@@ -84,13 +112,20 @@ public:
     cfg_pid_p = fix16_from_float(eeprom_float_read(CFG_PID_P_ADDR,
        CFG_PID_P_DEFAULT));
 
-    // CFG_PID_I in seconds, reverse and divide by tick frequency (40 Hz)
-    cfg_pid_i_inv = fix16_from_float(
-      1.0F
+    // CFG_PID_I in seconds, reverse and divide by PID frequency
+    cfg_pid_i_inv = pid_integral_t(
+      1.0
       / eeprom_float_read(CFG_PID_I_ADDR, CFG_PID_I_DEFAULT)
       / APP_PID_FREQUENCY
     );
 
+    // The same, per tick (for sync mode)
+    cfg_pid_i_inv_tick = Fixed<1, 31>(
+      1.0
+      / eeprom_float_read(CFG_PID_I_ADDR, CFG_PID_I_DEFAULT)
+      / APP_TICK_FREQUENCY
+    );
+
     float _rpm_max = eeprom_float_read(CFG_RPM_MAX_ADDR, CFG_RPM_MAX_DEFAULT);
 
     cfg_rpm_max_limit_norm = fix16_from_float(
@@ -112,7 +147,8 @@ private:
   fix16_t cfg_dead_zone_width_norm;
   // PID coefficients
   fix16_t cfg_pid_p;
-  fix16_t cfg_pid_i_inv;
+  pid_integral_t cfg_pid_i_inv;
+  Fixed<1, 31> cfg_pid_i_inv_tick;
   // Config limits are now in normalized [0.0..1.0] form of max motor RPM.
   fix16_t cfg_rpm_max_limit_norm;
   fix16_t cfg_rpm_min_limit_norm;
@@ -123,13 +159,18 @@ private:
   fix16_t knob_normalized;
 
 
-  fix16_t pid_speed_integral = 0;
+  pid_integral_t pid_speed_integral;
   fix16_t pid_limiter_integral = 0;
   fix16_t pid_speed_out = 0;
   bool limiter_active = false;
 
   uint32_t tick_freq_divide_counter = 0;
 
+  // Sync mode: ticks since last speed PID iteration, and divergence used
+  // in it
+  int ticks_elapsed = 0;
+  fix16_t pid_speed_divergence = 0;
+
   // Apply min/max limits to knob output
   fix16_t normalize_knob(fix16_t knob)
   {
@@ -147,13 +188,28 @@ private:
     fix16_t divergence = knob_normalized - in_speed;
 
     // pid_speed_integral += (1.0 / cfg_pid_i) * divergence;
-    fix16_t tmp = pid_speed_integral + fix16_mul(cfg_pid_i_inv, divergence);
-    pid_speed_integral = fix16_clamp(tmp, cfg_rpm_min_limit_norm, cfg_rpm_max_limit_norm);
+#if SPEED_PID_SYNC
+    // dt is variable, scale Ki. Interval is consumed here only, so time of
+    // skipped iterations (invalid speed, limiter) is not lost.
+    pid_integral_t ki = (cfg_pid_i_inv_tick * ticks_elapsed).to<8, 24>();
+    ticks_elapsed = 0;
+
+    pid_speed_integral += ki * pid_integral_t::from_fix16(pid_speed_divergence);
+    pid_speed_divergence = divergence;
+#else
+    pid_speed_integral += cfg_pid_i_inv * pid_integral_t::from_fix16(divergence);
+#endif
+
+    pid_integral_t integral_min = pid_integral_t::from_fix16(cfg_rpm_min_limit_norm);
+    pid_integral_t integral_max = pid_integral_t::from_fix16(cfg_rpm_max_limit_norm);
+
+    if (pid_speed_integral < integral_min) pid_speed_integral = integral_min;
+    if (pid_speed_integral > integral_max) pid_speed_integral = integral_max;
 
     fix16_t proportional = fix16_mul(cfg_pid_p, divergence);
 
     return fix16_clamp(
-      proportional + pid_speed_integral,
+      proportional + pid_speed_integral.to_fix16(),
       cfg_rpm_min_limit_norm,
       cfg_rpm_max_limit_norm
     );
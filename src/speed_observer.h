@@ -0,0 +1,88 @@
+#ifndef __SPEED_OBSERVER__
+#define __SPEED_OBSERVER__
+
+// Luenberger-style speed observer. Fuses noisy back-EMF speed measurements
+// with simple mechanical model of motor:
+//
+//   d(speed)/dt = (gain * power + offset - speed) / T
+//
+// - power - applied power, [0.0..1.0]
+// - gain - steady state speed for given power, 1.0 (max speed is measured
+//   at max power on calibration)
+// - offset - unknown disturbance (load, gain nonlinearity), estimated
+// - T - mechanical time constant
+//
+// Every update: predict speed by model for time elapsed since previous
+// update, then correct speed & offset with measurement residual. Elapsed
+// time is passed in ticks, so any mains frequency works. If measurement is
+// invalid, only predict.
+//
+// Cost: ~ 5 fix16_mul per mains period, < 1 cycle per tick on average.
+
+#include "app.h"
+#include "fix16_math/fix16_math.h"
+#include "fix16_math/fixed.h"
+
+// Correction gains for speed & disturbance
+#define SPEED_OBSERVER_K_SPEED F16(0.3)
+#define SPEED_OBSERVER_K_OFFSET F16(0.05)
+
+
+class SpeedObserver
+{
+public:
+  // Estimated speed
+  fix16_t speed = 0;
+  // Estimated disturbance (steady state speed offset)
+  fix16_t offset = 0;
+
+  // time_constant - mechanical time constant, sec
+  void configure(float time_constant)
+  {
+    // Per tick step is too small for fix16
+    cfg_model_step = Fixed<1, 31>(1.0 / (time_constant * APP_TICK_FREQUENCY));
+    // Model step should be < 1.0 (no overshoot)
+    cfg_max_ticks = (int)(time_constant * APP_TICK_FREQUENCY) - 1;
+  }
+
+  void reset()
+  {
+    speed = 0;
+    offset = 0;
+  }
+
+  // Model step only, when measurement is not trustable. ticks - time since
+  // previous update.
+  fix16_t predict(fix16_t power, int ticks)
+  {
+    if (ticks > cfg_max_ticks) ticks = cfg_max_ticks;
+
+    fix16_t step = (cfg_model_step * ticks).to_fix16();
+    speed += fix16_mul(power + offset - speed, step);
+
+    return speed;
+  }
+
+  // power - applied power, measurement - speed from back-EMF, ticks - time
+  // since previous update
+  fix16_t update(fix16_t power, fix16_t measurement, int ticks)
+  {
+    fix16_t predicted = predict(power, ticks);
+
+    // Correct
+    fix16_t residual = measurement - predicted;
+
+    speed = predicted + fix16_mul(residual, SPEED_OBSERVER_K_SPEED);
+    offset += fix16_mul(residual, SPEED_OBSERVER_K_OFFSET);
+
+    return speed;
+  }
+
+private:
+  // Model step per tick, 1 / (T * APP_TICK_FREQUENCY)
+  Fixed<1, 31> cfg_model_step;
+  int cfg_max_ticks = 0;
+};
+
+
+#endif
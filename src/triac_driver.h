@@ -6,11 +6,18 @@
 #include "fix16_math/fix16_math.h"
 
 #include "sensors.h"
+#include "triac_phase_table.h"
 
 // Don't open triac at the end of wave. Helps to avoid issues if measured zero
 // cross point drifted a bit.
 #define TRIAC_ZERO_TAIL_LENGTH 4
 
+// Set to 0 to calculate phase for resistive load (ignore motor inductance).
+// See triac_phase_table.h for details.
+#ifndef TRIAC_RL_COMPENSATION
+#define TRIAC_RL_COMPENSATION 1
+#endif
+
 class TriacDriver
 {
 public:
@@ -21,9 +28,15 @@ public:
   // Will be used to calculate opening phase for each half sine wave
   fix16_t setpoint = 0;
 
+  // Load angle (current lag), radians. Updated once per period from motor
+  // R & L, with back-EMF as additional resistance (it depends on speed).
+  fix16_t load_angle = 0;
+
   // 40 kHz
   void tick()
   {
+    sensors_ptr->in_power = setpoint;
+
     // Poor man zero cross check
     if (sensors_ptr->zero_cross_up || sensors_ptr->zero_cross_down) rearm();
 
@@ -53,14 +66,8 @@ public:
 
     // If ignition was not yet activated - check if we can do this
     if (!triac_open_done) {
-      // "Linearize" setpoint to phase shift & scale to 0..1
-      fix16_t normalized_setpoint = fix16_sinusize(setpoint);
-
-      // Calculate ticks treshold when ignition should be enabled:
-      // "mirror" and "enlarge" normalized setpoint
-      uint32_t ticks_threshold = fix16_to_int(
-        (fix16_one - normalized_setpoint) * positive_period_in_ticks
-      );
+      // Threshold is cached, recalculate only if setpoint changed
+      if (setpoint != threshold_setpoint) update_threshold();
 
       // We can open triack if:
       //
@@ -88,6 +95,11 @@ private:
   // Holds measured number of ticks per positive half-period
   uint32_t positive_period_in_ticks = 0;
 
+  // Tick when ignition should be enabled, and setpoint it was calculated
+  // for. Updated on rearm and on setpoint change only.
+  uint32_t ticks_threshold = 0;
+  fix16_t threshold_setpoint = 0;
+
   bool once_zero_crossed = false;
   bool once_period_counted = false;
 
@@ -101,6 +113,46 @@ private:
   }
 
 
+  void update_threshold()
+  {
+    threshold_setpoint = setpoint;
+
+    // "Linearize" setpoint to phase shift & scale to 0..1
+#if TRIAC_RL_COMPENSATION
+    fix16_t normalized_setpoint = triac_phase(setpoint, load_angle);
+#else
+    fix16_t normalized_setpoint = fix16_sinusize(setpoint);
+#endif
+
+    // Calculate ticks treshold when ignition should be enabled:
+    // "mirror" and "enlarge" normalized setpoint
+    ticks_threshold = fix16_to_int(
+      (fix16_one - normalized_setpoint) * positive_period_in_ticks
+    );
+  }
+
+  // tan(phi) = wL / (R + R_ekv)
+  void update_load_angle()
+  {
+    if (!positive_period_in_ticks) return;
+
+    // w = 2 * PI * f = PI * APP_TICK_FREQUENCY / positive_period_in_ticks
+    fix16_t reactance = (fix16_t)(
+      (int64_t)sensors_ptr->cfg_motor_inductance * (int)(3.14159265 * APP_TICK_FREQUENCY)
+      / positive_period_in_ticks
+    );
+
+    // `speed` is calibrated curve of linear speed (R_ekv / factor),
+    // restore linear one first
+    fix16_t resistance = sensors_ptr->cfg_motor_resistance + fix16_mul(
+      sensors_ptr->cfg_speed_table.eval_inverse(sensors_ptr->speed),
+      sensors_ptr->cfg_rekv_to_speed_factor
+    );
+
+    // Up to PI/2. Phase table covers [0..1.5] rad, clamps the rest.
+    load_angle = fix16_atan2(reactance, resistance);
+  }
+
   // Happens on every zero cross
   void rearm()
   {
@@ -113,9 +165,18 @@ private:
     if (once_period_counted)
     {
       // Measure period on positive half wave only
-      if (sensors_ptr->zero_cross_down) positive_period_in_ticks = phase_counter;
+      if (sensors_ptr->zero_cross_down)
+      {
+        positive_period_in_ticks = phase_counter;
+#if TRIAC_RL_COMPENSATION
+        update_load_angle();
+#endif
+      }
     }
 
+    // Period could be changed => recalculate
+    update_threshold();
+
     phase_counter = 0;
     triac_open_done = false;
     triac_close_done = false;
@@ -0,0 +1,264 @@
+#ifndef __TRIAC_PHASE_TABLE__
+#define __TRIAC_PHASE_TABLE__
+
+// Convert linear requested "energy" to triac phase, for inductive (RL) load.
+//
+// `fix16_sinusize` assumes resistive load: current stops at voltage zero, and
+// applied voltage area is (1 + cos(a)) / 2 for opening angle `a`. With RL
+// load current lags voltage by angle `phi` (tan(phi) = wL / R). It continues
+// to flow after voltage zero, until extinction angle `b` in (PI, PI + phi),
+// and negative voltage is applied to motor at this time. Then:
+//
+//   energy = (cos(a) - cos(b)) / (2 * cos(phi))
+//
+// - `b` is a root of: sin(b - phi) = sin(a - phi) * exp(-(b - a) / tan(phi))
+// - normalized to 1.0 for a <= phi (continuous conduction)
+// - for phi = 0 it's the same as `fix16_sinusize`
+//
+// Table is 2D: energy x load angle. Generated at compile time, values are
+// bilinearly interpolated. Output has the same format as `fix16_sinusize`
+// (1 - a / PI).
+//
+// Load angle is clamped to the last row. PI/2 (pure inductance) is singular
+// (cos(phi) = 0), so the axis ends a bit below it.
+//
+// Limitation: table is ideal RL model only. Load angle comes from
+// calibrated L & R and from R_ekv by speed, measured current lag is not
+// used, and nothing corrects the model (iron saturation, brush drop).
+//
+// Size: 13 x 33 x uint16 = 858 bytes of flash. Max abs error (see tests):
+// 0.056 near energy 0 (curve is steeper than for resistive load), 0.0022 in
+// [0.05..0.95].
+
+#include <stdint.h>
+
+#include "libfixmath/fix16.h"
+
+// Energy axis - 2^5 intervals in [0..1]
+#define TRIAC_PHASE_SETPOINT_BITS 5
+// Load angle axis - 1/2^3 radian step, 12 intervals => [0..1.5] radians
+// (~ 86 degrees, wL / R = 14)
+#define TRIAC_PHASE_ANGLE_BITS 3
+#define TRIAC_PHASE_ANGLE_INTERVALS 12
+
+namespace triac_phase_detail {
+
+constexpr double PI = 3.14159265358979323846;
+
+// Taylor series, for x in [-PI..2 * PI]. Argument is reduced to
+// [-PI/2..PI/2] first.
+constexpr double sin_taylor(double x)
+{
+  if (x > PI) x -= 2 * PI;
+  if (x > PI / 2) x = PI - x;
+  if (x < -PI / 2) x = -PI - x;
+
+  double term = x;
+  double sum = x;
+
+  for (int n = 1; n < 9; n++)
+  {
+    term *= -x * x / ((2 * n) * (2 * n + 1));
+    sum += term;
+  }
+  return sum;
+}
+
+constexpr double cos_taylor(double x)
+{
+  return sin_taylor(x + PI / 2);
+}
+
+// For x <= 0. Argument is scaled down to converge quickly, then result is
+// squared back.
+constexpr double exp_taylor(double x)
+{
+  if (x < -40) return 0;
+
+  int k = 0;
+  while (x < -0.5) { x /= 2; k++; }
+
+  double term = 1;
+  double sum = 1;
+
+  for (int n = 1; n < 10; n++)
+  {
+    term *= x / n;
+    sum += term;
+  }
+
+  while (k--) sum *= sum;
+  return sum;
+}
+
+constexpr double sqrt_newton(double x)
+{
+  double r = x > 1 ? x : 1;
+
+  for (int i = 0; i < 30; i++) r = (r + x / r) / 2;
+  return r;
+}
+
+// Opening angle `a` & extinction angle `b` for given energy `x`, as root of:
+//
+//   F1 = (cos(a) - cos(b)) / (2 * cos(phi)) - x = 0
+//   F2 = sin(b - phi) - sin(a - phi) * exp(-(b - a) / tan(phi)) = 0
+//
+// 2D Newton iterations, starting from (a, b). Result is written back.
+constexpr void solve(double x, double phi, double &a, double &b)
+{
+  double norm = 2 * cos_taylor(phi);
+  double tan_phi = sin_taylor(phi) / cos_taylor(phi);
+
+  for (int i = 0; i < 30; i++)
+  {
+    double f1 = (cos_taylor(a) - cos_taylor(b)) / norm - x;
+    double j11 = -sin_taylor(a) / norm;
+    double j12 = sin_taylor(b) / norm;
+
+    // Resistive load => b = PI
+    double f2 = b - PI;
+    double j21 = 0;
+    double j22 = 1;
+
+    if (phi > 0)
+    {
+      double e = exp_taylor(-(b - a) / tan_phi);
+      double k = sin_taylor(a - phi) * e;
+
+      f2 = sin_taylor(b - phi) - k;
+      j21 = -cos_taylor(a - phi) * e - k / tan_phi;
+      j22 = cos_taylor(b - phi) + k / tan_phi;
+    }
+
+    double det = j11 * j22 - j12 * j21;
+    double da = (f1 * j22 - f2 * j12) / det;
+    double db = (f2 * j11 - f1 * j21) / det;
+
+    // Damp step, if it leaves allowed area
+    for (int k = 0; k < 30; k++)
+    {
+      if (a - da >= phi && a - da <= PI && b - db >= PI && b - db <= PI + phi) break;
+      da /= 2;
+      db /= 2;
+    }
+
+    a -= da;
+    b -= db;
+
+    if (da < 1e-10 && da > -1e-10 && db < 1e-10 && db > -1e-10) break;
+  }
+}
+
+// Extinction angle for opening angle `a`, bisection. For initial guess only.
+constexpr double extinction(double a, double phi)
+{
+  if (phi <= 0) return PI;
+
+  double tan_phi = sin_taylor(phi) / cos_taylor(phi);
+  double lo = PI;
+  double hi = PI + phi;
+
+  for (int i = 0; i < 50; i++)
+  {
+    double mid = (lo + hi) / 2;
+
+    if (sin_taylor(mid - phi) > sin_taylor(a - phi) * exp_taylor(-(mid - a) / tan_phi)) lo = mid;
+    else hi = mid;
+  }
+  return (lo + hi) / 2;
+}
+
+} // namespace triac_phase_detail
+
+
+template <int SETPOINT_BITS, int ANGLE_BITS, int ANGLE_INTERVALS>
+struct TriacPhaseTable
+{
+  enum {
+    SETPOINT_SIZE = (1 << SETPOINT_BITS) + 1,
+    ANGLE_SIZE = ANGLE_INTERVALS + 1
+  };
+
+  // fix16 values, clamped to 65535 (1.0 - 1). One row per load angle.
+  uint16_t data[ANGLE_SIZE][SETPOINT_SIZE];
+
+  constexpr TriacPhaseTable() : data()
+  {
+    using triac_phase_detail::PI;
+
+    for (int j = 0; j < ANGLE_SIZE; j++)
+    {
+      double phi = (double)j / (1 << ANGLE_BITS);
+
+      // Go from 0 to 1, previous solution is good initial guess. Start
+      // point (a = b = PI) is degenerate, use resistive approximation
+      // for the first step.
+      double x0 = 1.0 / (SETPOINT_SIZE - 1);
+      double a = PI - 2 * triac_phase_detail::sqrt_newton(x0);
+      double b = triac_phase_detail::extinction(a, phi);
+
+      for (int i = 0; i < SETPOINT_SIZE; i++)
+      {
+        double y = 0;
+
+        if (i == SETPOINT_SIZE - 1) y = 1 - phi / PI;
+        else if (i > 0)
+        {
+          triac_phase_detail::solve((double)i / (SETPOINT_SIZE - 1), phi, a, b);
+          y = 1 - a / PI;
+        }
+
+        long val = (long)(y * 65536 + 0.5);
+
+        data[j][i] = (uint16_t)(val > 65535 ? 65535 : val);
+      }
+    }
+  }
+};
+
+template <int SETPOINT_BITS, int ANGLE_BITS, int ANGLE_INTERVALS>
+constexpr TriacPhaseTable<SETPOINT_BITS, ANGLE_BITS, ANGLE_INTERVALS> triac_phase_table =
+  TriacPhaseTable<SETPOINT_BITS, ANGLE_BITS, ANGLE_INTERVALS>();
+
+
+// - setpoint: [0.0..1.0), desired energy (equivalent to 0..100%)
+// - angle: [0.0..ANGLE_INTERVALS / 2^ANGLE_BITS), load angle (current lag),
+//   radians
+// - Output: [0.0..1.0)
+template <int SETPOINT_BITS, int ANGLE_BITS, int ANGLE_INTERVALS>
+static inline fix16_t triac_phase_lut(fix16_t setpoint, fix16_t angle)
+{
+  const int x_shift = 16 - SETPOINT_BITS;
+  const int a_shift = 16 - ANGLE_BITS;
+  const auto &table = triac_phase_table<SETPOINT_BITS, ANGLE_BITS, ANGLE_INTERVALS>.data;
+
+  // Clamp to table range, last point excluded (interpolation needs next one)
+  setpoint = fix16_max(fix16_min(setpoint, fix16_one - 1), 0);
+  angle = fix16_max(fix16_min(angle, (ANGLE_INTERVALS << a_shift) - 1), 0);
+
+  int i = setpoint >> x_shift;
+  int x_frac = setpoint & ((1 << x_shift) - 1);
+  int j = angle >> a_shift;
+  int a_frac = angle & ((1 << a_shift) - 1);
+
+  // Interpolate by setpoint in both rows, then by angle
+  int y0 = table[j][i];
+  int y1 = table[j + 1][i];
+
+  y0 += ((table[j][i + 1] - y0) * x_frac) >> x_shift;
+  y1 += ((table[j + 1][i + 1] - y1) * x_frac) >> x_shift;
+
+  return y0 + (((y1 - y0) * a_frac) >> a_shift);
+}
+
+static inline fix16_t triac_phase(fix16_t setpoint, fix16_t angle)
+{
+  return triac_phase_lut<
+    TRIAC_PHASE_SETPOINT_BITS,
+    TRIAC_PHASE_ANGLE_BITS,
+    TRIAC_PHASE_ANGLE_INTERVALS
+  >(setpoint, angle);
+}
+
+#endif
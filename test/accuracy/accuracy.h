@@ -0,0 +1,110 @@
+#ifndef __TEST_ACCURACY__
+#define __TEST_ACCURACY__
+
+// Accuracy statistics for fixed point kernels, vs double precision reference.
+//
+// - error is measured in ULP of result format (1/65536 for fix16, 1 for
+//   integers)
+// - samples with reference outside of result range are counted as
+//   overflows (not included in error stats), and range of inputs where it
+//   happens is reported
+//
+// Inputs come from sweeps or from `accuracy_random()` (fixed seed, results
+// are reproducible).
+
+#include <stdio.h>
+#include <stdint.h>
+#include <math.h>
+
+class AccuracyStats
+{
+public:
+  const char *name;
+
+  long samples = 0;
+  double max_ulp = 0;
+  double sum_ulp = 0;
+  // Input, where max error happened
+  double worst_input = 0;
+
+  long overflows = 0;
+  double overflow_min = 0;
+  double overflow_max = 0;
+
+  // - ulp: result resolution
+  // - range: max abs value of result
+  AccuracyStats(const char *name, double ulp = 1.0 / 65536, double range = 32768.0)
+    : name(name), ulp(ulp), range(range) {}
+
+  // `input` is any value to identify sample in report (argument or it's
+  // combination)
+  void add(double input, double actual, double reference)
+  {
+    if (reference >= range || reference < -range)
+    {
+      if (!overflows || input < overflow_min) overflow_min = input;
+      if (!overflows || input > overflow_max) overflow_max = input;
+      overflows++;
+      return;
+    }
+
+    double err = fabs(actual - reference) / ulp;
+
+    samples++;
+    sum_ulp += err;
+
+    if (err > max_ulp)
+    {
+      max_ulp = err;
+      worst_input = input;
+    }
+  }
+
+  double mean_ulp() const { return samples ? sum_ulp / samples : 0; }
+
+  void report() const
+  {
+    printf("  %-28s samples %8ld  max %9.3f ulp (at %g)  mean %7.3f ulp",
+      name, samples, max_ulp, worst_input, mean_ulp());
+
+    if (overflows)
+    {
+      printf("  overflow %ld in [%g..%g]", overflows, overflow_min, overflow_max);
+    }
+
+    printf("\n");
+  }
+
+private:
+  double ulp;
+  double range;
+};
+
+
+// xorshift32, fixed seed
+static inline uint32_t accuracy_random()
+{
+  static uint32_t state = 2463534242U;
+
+  state ^= state << 13;
+  state ^= state >> 17;
+  state ^= state << 5;
+  return state;
+}
+
+// Uniform in [from..to)
+static inline double accuracy_random(double from, double to)
+{
+  return from + (to - from) * (accuracy_random() / 4294967296.0);
+}
+
+// Log-uniform magnitude in [from..to), random sign. To cover all scales
+// of fix16 range, including overflow area.
+static inline double accuracy_random_log(double from, double to)
+{
+  double val = exp(accuracy_random(log(from), log(to)));
+
+  return (accuracy_random() & 1) ? val : -val;
+}
+
+#endif
@@ -0,0 +1,251 @@
+#ifdef UNIT_TEST
+
+#include <unity.h>
+#include <math.h>
+
+#include "../src/fix16_math/fix16_math.h"
+#include "../src/fix16_math/fix_recip.h"
+#include "../src/truncated_mean.h"
+#include "../src/sensors.h"
+#include "accuracy.h"
+
+// Error bounds of fixed point kernels (FIXMATH_NO_ROUNDING), vs double
+// precision reference. Reports are printed, asserted limits are measured
+// max + small margin - if one fails, kernel accuracy changed.
+
+static double fix16_to_double(fix16_t x) { return x / 65536.0; }
+
+
+void test_accuracy_fix16_mul() {
+  AccuracyStats stats("fix16_mul");
+
+  for (int i = 0; i < 1000000; i++)
+  {
+    fix16_t a = fix16_from_dbl(accuracy_random_log(1.0 / 256, 4096));
+    fix16_t b = fix16_from_dbl(accuracy_random_log(1.0 / 256, 4096));
+    double ref = fix16_to_double(a) * fix16_to_double(b);
+
+    stats.add(fabs(ref), fix16_to_double(fix16_mul(a, b)), ref);
+  }
+
+  stats.report();
+  TEST_ASSERT_TRUE(stats.max_ulp < 1);
+}
+
+
+void test_accuracy_fix16_div() {
+  AccuracyStats stats("fix16_div");
+
+  for (int i = 0; i < 1000000; i++)
+  {
+    fix16_t a = fix16_from_dbl(accuracy_random_log(1.0 / 256, 16384));
+    fix16_t b = fix16_from_dbl(accuracy_random_log(1.0 / 256, 256));
+    double ref = fix16_to_double(a) / fix16_to_double(b);
+
+    stats.add(fabs(ref), fix16_to_double(fix16_div(a, b)), ref);
+  }
+
+  stats.report();
+  TEST_ASSERT_TRUE(stats.max_ulp < 1);
+}
+
+
+void test_accuracy_fix_recip() {
+  AccuracyStats stats("FixRecip::div");
+
+  for (int i = 0; i < 1000000; i++)
+  {
+    fix16_t a = fix16_from_dbl(accuracy_random_log(1.0 / 256, 16384));
+    fix16_t b = fix16_from_dbl(accuracy_random_log(1.0 / 256, 256));
+    double ref = fix16_to_double(a) / fix16_to_double(b);
+
+    if (fabs(ref) >= 32768)
+    {
+      // Quotient overflow is not checked in FixRecip, don't call it
+      stats.add(fabs(ref), 0, ref);
+      continue;
+    }
+
+    stats.add(fabs(ref), fix16_to_double(FixRecip(b).div(a)), ref);
+  }
+
+  stats.report();
+  // Documented bound: 2 + |quotient| / 2^28 LSB
+  TEST_ASSERT_TRUE(stats.max_ulp < 2 + 32768.0 * 65536 / (1 << 28));
+}
+
+
+void test_accuracy_fix16_sinusize() {
+  AccuracyStats stats("fix16_sinusize");
+
+  for (fix16_t x = 0; x < fix16_one; x++)
+  {
+    double ref = asin(2 * fix16_to_double(x) - 1) / M_PI + 0.5;
+
+    stats.add(fix16_to_double(x), fix16_to_double(fix16_sinusize(x)), ref);
+  }
+
+  stats.report();
+  // Error is max near 0 and 1, where curve is steep
+  TEST_ASSERT_TRUE(stats.max_ulp < 1000);
+  TEST_ASSERT_TRUE(stats.mean_ulp() < 15);
+}
+
+
+void test_accuracy_truncated_mean_window() {
+  // Intermediate is 16x of result, and should fit in 31 bits
+  AccuracyStats stats("truncated_mean window^2", 1, 1 << 27);
+  double max_relative = 0;
+
+  for (fix16_t window = F16(1); window <= F16(2); window += 97)
+  {
+    // 12-bit ADC data => sigma^2 is 22 bits max. Go above, to find overflow.
+    for (int sigma_square = 1; sigma_square < (1 << 26); sigma_square += sigma_square / 8 + 1)
+    {
+      double w = fix16_to_double(window);
+      double ref = w * w * sigma_square;
+
+      if (ref >= (1 << 27)) { stats.add(sigma_square, 0, ref); continue; }
+
+      double actual = truncated_mean_window_square(sigma_square, window);
+
+      stats.add(sigma_square, actual, ref);
+
+      if (sigma_square >= 16) max_relative = fmax(max_relative, fabs(actual - ref) / ref);
+    }
+  }
+
+  stats.report();
+  printf("  %-28s max relative error %.4f\n", "", max_relative);
+
+  // Window^2 is truncated to 4 fractional bits (window - to 8 bits before)
+  TEST_ASSERT_TRUE(max_relative < 0.09);
+  // No overflow for real data
+  TEST_ASSERT_TRUE(stats.overflow_min > (1 << 22));
+}
+
+
+// Same algorithm in doubles: exact mean, sigma & window
+static double truncated_mean_reference(const uint16_t *src, int count, double window)
+{
+  double s = 0;
+  double s2 = 0;
+
+  for (int i = 0; i < count; i++)
+  {
+    s += src[i];
+    s2 += (double)src[i] * src[i];
+  }
+
+  double mean = s / count;
+  double sigma_square = (s2 - s * s / count) / (count - 1);
+
+  double sum = 0;
+  int cnt = 0;
+
+  for (int i = 0; i < count; i++)
+  {
+    double d = src[i] - mean;
+
+    if (d * d < window * window * sigma_square)
+    {
+      sum += src[i];
+      cnt++;
+    }
+  }
+
+  return cnt ? sum / cnt : mean;
+}
+
+void test_accuracy_truncated_mean() {
+  AccuracyStats stats("truncated_mean", 1, 4096);
+  uint16_t buf[ADC_FETCH_PER_TICK];
+
+  for (int i = 0; i < 200000; i++)
+  {
+    double base = accuracy_random(100, 3900);
+    double noise = accuracy_random(0, 50);
+
+    for (int k = 0; k < ADC_FETCH_PER_TICK; k++)
+    {
+      double val = base + accuracy_random(-noise, noise);
+
+      // Spikes
+      if ((accuracy_random() & 7) == 0) val += accuracy_random(-150, 150);
+
+      buf[k] = (uint16_t)fmin(fmax(val, 0), 4095);
+    }
+
+    stats.add(
+      base,
+      truncated_mean(buf, ADC_FETCH_PER_TICK, F16(1.1)),
+      truncated_mean_reference(buf, ADC_FETCH_PER_TICK, 1.1)
+    );
+  }
+
+  stats.report();
+  // Rare big errors - sample near threshold is classified differently
+  // (integer mean & truncated window). Average is below rounding error.
+  TEST_ASSERT_TRUE(stats.max_ulp < 30);
+  TEST_ASSERT_TRUE(stats.mean_ulp() < 0.5);
+}
+
+
+void test_accuracy_sensors_conversion() {
+  static Sensors sensors;
+  static uint16_t buf[ADC_FETCH_PER_TICK * ADC_CHANNELS_COUNT];
+
+  AccuracyStats voltage_stats("Sensors::get_voltage");
+  AccuracyStats current_stats("Sensors::get_current");
+
+  sensors.configure();
+
+  double shunt = CFG_SHUNT_RESISTANCE_DEFAULT * 50 / 1000;
+
+  for (int vrefin = 1400; vrefin <= 1600; vrefin += 8)
+  {
+    for (int adc = 1; adc < 4096; adc++)
+    {
+      for (int k = 0; k < ADC_FETCH_PER_TICK; k++)
+      {
+        buf[k * 4] = adc;
+        buf[k * 4 + 1] = adc;
+        buf[k * 4 + 2] = 0;
+        buf[k * 4 + 3] = vrefin;
+      }
+
+      sensors.adc_raw_data_load(buf, 0);
+      sensors.tick();
+
+      double v_ref = 1.2 * 4096 / vrefin;
+
+      voltage_stats.add(adc, fix16_to_double(sensors.get_voltage()),
+        adc / 4096.0 * v_ref * (301.5 / 1.5));
+      current_stats.add(adc, fix16_to_double(sensors.get_current()),
+        adc / 4096.0 * v_ref / shunt);
+    }
+  }
+
+  voltage_stats.report();
+  current_stats.report();
+
+  // Error of v_ref (~ 2^-16 relative) is scaled by divider ratio => ~ 0.01V
+  TEST_ASSERT_TRUE(voltage_stats.max_ulp < 600);
+  TEST_ASSERT_TRUE(current_stats.max_ulp < 6);
+}
+
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_accuracy_fix16_mul);
+  RUN_TEST(test_accuracy_fix16_div);
+  RUN_TEST(test_accuracy_fix_recip);
+  RUN_TEST(test_accuracy_fix16_sinusize);
+  RUN_TEST(test_accuracy_truncated_mean_window);
+  RUN_TEST(test_accuracy_truncated_mean);
+  RUN_TEST(test_accuracy_sensors_conversion);
+  UNITY_END();
+}
+
+
+#endif
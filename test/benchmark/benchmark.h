@@ -0,0 +1,151 @@
+#ifndef __TEST_BENCHMARK__
+#define __TEST_BENCHMARK__
+
+// Minimal benchmark harness for host tests.
+//
+// - `benchmark_ns()` runs function several times and returns the best time
+//   per operation, in ns.
+// - results are printed and written as JSON to BENCHMARK_OUTPUT (env var),
+//   if set.
+// - if BENCHMARK_BASELINE (env var) points to previous JSON, results are
+//   compared, and regressions above BENCHMARK_TOLERANCE (default 0.25, 25%)
+//   are reported as failures.
+//
+// JSON format (one result per line, to parse baseline without library):
+//
+// {
+//   "benchmarks": [
+//     {"name": "fix16_mul", "ns": 1.234},
+//     ...
+//   ]
+// }
+
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BENCHMARK_MAX_RESULTS 64
+#define BENCHMARK_NAME_LENGTH 64
+
+struct BenchmarkResult
+{
+  char name[BENCHMARK_NAME_LENGTH];
+  double ns;
+};
+
+static BenchmarkResult benchmark_results[BENCHMARK_MAX_RESULTS];
+static int benchmark_results_count = 0;
+
+// `fn(i)` is one operation, `ops` - number of operations per run
+template <typename F>
+static double benchmark_ns(F fn, int ops)
+{
+  double best = 0;
+
+  for (int run = 0; run < 5; run++)
+  {
+    auto t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < ops; i++) fn(i);
+    auto t1 = std::chrono::steady_clock::now();
+
+    double ns = std::chrono::duration<double, std::nano>(t1 - t0).count() / ops;
+    if (run == 0 || ns < best) best = ns;
+  }
+
+  return best;
+}
+
+static void benchmark_report(const char *name, double ns)
+{
+  if (benchmark_results_count >= BENCHMARK_MAX_RESULTS) return;
+
+  BenchmarkResult &r = benchmark_results[benchmark_results_count++];
+
+  snprintf(r.name, sizeof(r.name), "%s", name);
+  r.ns = ns;
+
+  printf("  %-32s %8.2f ns\n", name, ns);
+}
+
+static void benchmark_write_json(FILE *out)
+{
+  fprintf(out, "{\n  \"benchmarks\": [\n");
+
+  for (int i = 0; i < benchmark_results_count; i++)
+  {
+    fprintf(out, "    {\"name\": \"%s\", \"ns\": %.3f}%s\n",
+      benchmark_results[i].name,
+      benchmark_results[i].ns,
+      i < benchmark_results_count - 1 ? "," : "");
+  }
+
+  fprintf(out, "  ]\n}\n");
+}
+
+// Returns number of regressions
+static int benchmark_compare(const char *baseline_path, double tolerance)
+{
+  FILE *f = fopen(baseline_path, "r");
+
+  if (!f)
+  {
+    printf("  Can't open baseline %s\n", baseline_path);
+    return 1;
+  }
+
+  char line[256];
+  int regressions = 0;
+
+  while (fgets(line, sizeof(line), f))
+  {
+    char name[BENCHMARK_NAME_LENGTH];
+    double baseline_ns;
+
+    if (sscanf(line, " {\"name\": \"%63[^\"]\", \"ns\": %lf}", name, &baseline_ns) != 2) continue;
+
+    for (int i = 0; i < benchmark_results_count; i++)
+    {
+      if (strcmp(name, benchmark_results[i].name)) continue;
+
+      double ratio = benchmark_results[i].ns / baseline_ns;
+      bool regression = ratio > 1 + tolerance;
+
+      printf("  %-32s %8.2f -> %8.2f ns (x%.2f)%s\n", name, baseline_ns,
+        benchmark_results[i].ns, ratio, regression ? " REGRESSION" : "");
+
+      if (regression) regressions++;
+    }
+  }
+
+  fclose(f);
+  return regressions;
+}
+
+// Write results & compare with baseline, according to env vars. Returns
+// number of regressions.
+static int benchmark_finish()
+{
+  const char *output = getenv("BENCHMARK_OUTPUT");
+  const char *baseline = getenv("BENCHMARK_BASELINE");
+  const char *tolerance = getenv("BENCHMARK_TOLERANCE");
+
+  if (output)
+  {
+    FILE *f = fopen(output, "w");
+
+    if (f)
+    {
+      benchmark_write_json(f);
+      fclose(f);
+    }
+    else printf("  Can't write %s\n", output);
+  }
+  else benchmark_write_json(stdout);
+
+  if (!baseline) return 0;
+
+  return benchmark_compare(baseline, tolerance ? atof(tolerance) : 0.25);
+}
+
+#endif
@@ -0,0 +1,212 @@
+#ifdef UNIT_TEST
+
+#include <unity.h>
+#include <math.h>
+#include <stdlib.h>
+
+#include "../src/fix16_math/fix16_math.h"
+#include "../src/fix16_math/fix_recip.h"
+#include "../src/truncated_mean.h"
+#include "../src/median.h"
+#include "../src/sensors.h"
+#include "../motor_sim.h"
+#include "benchmark.h"
+
+// Hot path primitives, compared with float & int64 alternatives. Run with
+// BENCHMARK_OUTPUT / BENCHMARK_BASELINE env vars to save & compare results
+// (see benchmark.h).
+
+#define DATA_LEN 1024
+#define OPS (DATA_LEN * 1000)
+
+static fix16_t fix_a[DATA_LEN];
+static fix16_t fix_b[DATA_LEN];
+static float float_a[DATA_LEN];
+static float float_b[DATA_LEN];
+
+static volatile fix16_t fix_sink;
+static volatile float float_sink;
+
+
+static void fill_data()
+{
+  srand(1);
+
+  for (int i = 0; i < DATA_LEN; i++)
+  {
+    // Typical ranges - volts & amperes
+    fix_a[i] = rand() % F16(320);
+    fix_b[i] = F16(0.01) + rand() % F16(10);
+    float_a[i] = fix16_to_float(fix_a[i]);
+    float_b[i] = fix16_to_float(fix_b[i]);
+  }
+}
+
+
+void test_benchmark_mul() {
+  benchmark_report("fix16_mul", benchmark_ns([](int i) {
+    fix_sink = fix16_mul(fix_a[i % DATA_LEN], fix_b[i % DATA_LEN]);
+  }, OPS));
+
+  benchmark_report("mul_int64", benchmark_ns([](int i) {
+    fix_sink = (fix16_t)(((int64_t)fix_a[i % DATA_LEN] * fix_b[i % DATA_LEN]) >> 16);
+  }, OPS));
+
+  benchmark_report("mul_float", benchmark_ns([](int i) {
+    float_sink = float_a[i % DATA_LEN] * float_b[i % DATA_LEN];
+  }, OPS));
+}
+
+
+void test_benchmark_div() {
+  benchmark_report("fix16_div", benchmark_ns([](int i) {
+    fix_sink = fix16_div(fix_a[i % DATA_LEN], fix_b[i % DATA_LEN]);
+  }, OPS));
+
+  benchmark_report("div_int64", benchmark_ns([](int i) {
+    fix_sink = (fix16_t)(((int64_t)fix_a[i % DATA_LEN] << 16) / fix_b[i % DATA_LEN]);
+  }, OPS));
+
+  benchmark_report("div_float", benchmark_ns([](int i) {
+    float_sink = float_a[i % DATA_LEN] / float_b[i % DATA_LEN];
+  }, OPS));
+
+  static FixRecip recip(F16(450));
+
+  benchmark_report("div_fix_recip_cached", benchmark_ns([](int i) {
+    fix_sink = recip.div(fix_a[i % DATA_LEN]);
+  }, OPS));
+
+  benchmark_report("div_fix_recip_set", benchmark_ns([](int i) {
+    fix_sink = FixRecip(fix_b[i % DATA_LEN]).div(fix_a[i % DATA_LEN]);
+  }, OPS));
+}
+
+
+void test_benchmark_sinusize() {
+  benchmark_report("fix16_sinusize", benchmark_ns([](int i) {
+    fix_sink = fix16_sinusize((i * 64) & 0xFFFF);
+  }, OPS));
+
+  benchmark_report("sinusize_float", benchmark_ns([](int i) {
+    float_sink = asinf(2 * (((i * 64) & 0xFFFF) / 65536.0F) - 1) / (float)M_PI + 0.5F;
+  }, OPS));
+}
+
+
+void test_benchmark_truncated_mean() {
+  static uint16_t adc[DATA_LEN + ADC_FETCH_PER_TICK];
+
+  for (int i = 0; i < DATA_LEN + ADC_FETCH_PER_TICK; i++) adc[i] = 2000 + rand() % 40;
+
+  benchmark_report("truncated_mean_8", benchmark_ns([](int i) {
+    fix_sink = truncated_mean(adc + i % DATA_LEN, ADC_FETCH_PER_TICK, F16(1.1));
+  }, OPS / 10));
+
+  // Plain mean, for comparison
+  benchmark_report("mean_8", benchmark_ns([](int i) {
+    uint32_t s = 0;
+    for (int k = 0; k < ADC_FETCH_PER_TICK; k++) s += adc[i % DATA_LEN + k];
+    fix_sink = s / ADC_FETCH_PER_TICK;
+  }, OPS / 10));
+}
+
+
+void test_benchmark_median() {
+  // Speed filter from Sensors - 32 values, decimate on overflow. Window is
+  // up to ~ 90 samples.
+  static MedianIteratorTemplate<fix16_t, 32, MEDIAN_OVERFLOW_DECIMATE> median;
+
+  double add_ns = benchmark_ns([](int i) {
+    if (i % 90 == 0) median.reset();
+    median.add(fix_a[i % DATA_LEN]);
+  }, OPS / 10);
+
+  benchmark_report("median_add", add_ns);
+
+  benchmark_report("median_result", benchmark_ns([](int) {
+    fix_sink = median.result();
+  }, OPS));
+
+  // Worst case add() - decimation on overflow, split between 2 calls. Full
+  // filter is restored before every call, copy time is subtracted.
+  static MedianIteratorTemplate<fix16_t, 32, MEDIAN_OVERFLOW_DECIMATE> full, overflowed, work;
+
+  for (int i = 0; i < 32; i++) full.add(fix_a[i]);
+  overflowed = full;
+  overflowed.add(fix_a[32]);
+
+  double copy_ns = benchmark_ns([](int) { work = full; }, OPS / 10);
+
+  double overflow_ns = benchmark_ns([](int i) {
+    work = full;
+    work.add(fix_a[i % DATA_LEN]);
+  }, OPS / 10) - copy_ns;
+
+  double after_overflow_ns = benchmark_ns([](int i) {
+    work = overflowed;
+    work.add(fix_a[i % DATA_LEN]);
+  }, OPS / 10) - copy_ns;
+
+  benchmark_report("median_add_overflow", overflow_ns);
+  benchmark_report("median_add_after_overflow", after_overflow_ns);
+
+  // Decimation is amortised only. Keep worst case call within a few average
+  // ones, or it will not fit into tick.
+  TEST_ASSERT_TRUE(overflow_ns < add_ns * 4);
+  TEST_ASSERT_TRUE(after_overflow_ns < add_ns * 4);
+}
+
+
+void test_benchmark_sensors_tick() {
+  static Sensors sensors;
+  static MotorSimHalfWave hw;
+  static uint16_t buf[ADC_FETCH_PER_TICK * ADC_CHANNELS_COUNT];
+
+  MotorSimParams p;
+  p.noise = 2;
+  motor_sim_half_wave(p, hw);
+
+  sensors.configure();
+
+  // Positive half-wave from sim, then negative one (zero voltage)
+  benchmark_report("sensors_tick", benchmark_ns([](int i) {
+    int t = i % (hw.ticks * 2);
+    bool positive = t < hw.ticks;
+
+    for (int k = 0; k < ADC_FETCH_PER_TICK; k++)
+    {
+      buf[k * 4] = positive ? hw.voltage[t] : 0;
+      buf[k * 4 + 1] = positive ? hw.current[t] : 0;
+      buf[k * 4 + 2] = 0;
+      buf[k * 4 + 3] = 1489;
+    }
+
+    sensors.in_triac_on = positive && hw.triac_on[t];
+    sensors.adc_raw_data_load(buf, 0);
+    sensors.tick();
+  }, hw.ticks * 2 * 100));
+}
+
+
+void test_benchmark_baseline() {
+  TEST_ASSERT_EQUAL(0, benchmark_finish());
+}
+
+
+int main() {
+  fill_data();
+
+  UNITY_BEGIN();
+  RUN_TEST(test_benchmark_mul);
+  RUN_TEST(test_benchmark_div);
+  RUN_TEST(test_benchmark_sinusize);
+  RUN_TEST(test_benchmark_truncated_mean);
+  RUN_TEST(test_benchmark_median);
+  RUN_TEST(test_benchmark_sensors_tick);
+  RUN_TEST(test_benchmark_baseline);
+  UNITY_END();
+}
+
+
+#endif
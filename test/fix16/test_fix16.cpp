@@ -1,8 +1,11 @@
 #ifdef UNIT_TEST
 
 #include <unity.h>
+#include <stdio.h>
+#include <math.h>
 
 #include "../src/fix16_math/fix16_math.h"
+#include "../src/fix16_math/fix16_lut.h"
 
 
 void test_fix16_div() {
@@ -10,9 +13,132 @@ void test_fix16_div() {
 }
 
 
+void test_fix16_lut_identity() {
+  Fix16Lut<3> lut;
+
+  TEST_ASSERT_EQUAL(lut.eval(0), 0);
+  TEST_ASSERT_EQUAL(lut.eval(F16(0.3)), F16(0.3));
+  TEST_ASSERT_EQUAL(lut.eval(F16(1)), F16(1));
+}
+
+
+void test_fix16_lut_interpolation() {
+  Fix16Lut<3> lut;
+
+  // y = x^2 at breakpoints
+  for (int i = 0; i < lut.SIZE; i++) lut.table[i] = F16(i * i / 64.0);
+
+  TEST_ASSERT_EQUAL(lut.eval(F16(0.5)), F16(0.25));
+  // Between 0.5 and 0.625 => (0.25 + 0.390625) / 2
+  TEST_ASSERT_INT_WITHIN(1, lut.eval(F16(0.5625)), F16(0.3203125));
+  // Negative input is clamped
+  TEST_ASSERT_EQUAL(lut.eval(F16(-0.2)), 0);
+  // Above 1.0 - extrapolated with last slope (15/64 per 1/8)
+  TEST_ASSERT_INT_WITHIN(1, lut.eval(F16(1.125)), F16(1 + 15.0 / 64));
+}
+
+
+void test_fix16_lut_inverse() {
+  Fix16Lut<3> lut;
+
+  TEST_ASSERT_EQUAL(lut.eval_inverse(F16(0.3)), F16(0.3));
+
+  // y = x^2 at breakpoints
+  for (int i = 0; i < lut.SIZE; i++) lut.table[i] = F16(i * i / 64.0);
+
+  // Slope of first interval is 1/8 => rounding error is 8x in inverse
+  for (fix16_t x = 0; x <= F16(1.2); x += 997)
+  {
+    TEST_ASSERT_INT_WITHIN(8, x, lut.eval_inverse(lut.eval(x)));
+  }
+
+  TEST_ASSERT_EQUAL(lut.eval_inverse(F16(-0.1)), 0);
+}
+
+
+static double sinusize_reference(double x)
+{
+  return asin(2 * x - 1) / M_PI + 0.5;
+}
+
+// Previous implementation: 512 entries on [0..1] grid, no interpolation,
+// low input bits dropped.
+static double sinusize_legacy(fix16_t x)
+{
+  int idx = x >> 7;
+  double y = floor(sinusize_reference(idx / 511.0) * 65536 + 0.5);
+  return fmin(y, 65535) / 65536;
+}
+
+template <int SIZE_BITS>
+static double sinusize_max_error(fix16_t from, fix16_t to)
+{
+  double max_error = 0;
+
+  for (fix16_t x = from; x < to; x++)
+  {
+    double error = fabs(fix16_to_float(fix16_sinusize_lut<SIZE_BITS>(x)) -
+      sinusize_reference(x / 65536.0));
+    if (error > max_error) max_error = error;
+  }
+  return max_error;
+}
+
+
+void test_fix16_sinusize_table() {
+  const Fix16SinusizeTable<7> &table = fix16_sinusize_table<7>;
+
+  // Breakpoints should match math library within rounding
+  for (int i = 0; i < table.SIZE - 1; i++)
+  {
+    double y = sinusize_reference((double)i / (table.SIZE - 1)) * 65536;
+    TEST_ASSERT_FLOAT_WITHIN(0.51, y, table.data[i]);
+  }
+  TEST_ASSERT_EQUAL(65535, table.data[table.SIZE - 1]);
+
+  TEST_ASSERT_EQUAL(0, fix16_sinusize(0));
+  TEST_ASSERT_EQUAL(F16(0.5), fix16_sinusize(F16(0.5)));
+  TEST_ASSERT_EQUAL(0, fix16_sinusize(F16(-0.5)));
+  TEST_ASSERT_TRUE(fix16_sinusize(F16(2)) <= 65535);
+}
+
+
+void test_fix16_sinusize_precision() {
+  double legacy_max = 0;
+  double legacy_mid = 0;
+
+  for (fix16_t x = 0; x < fix16_one; x++)
+  {
+    double error = fabs(sinusize_legacy(x) - sinusize_reference(x / 65536.0));
+    if (error > legacy_max) legacy_max = error;
+    if (x >= F16(0.05) && x < F16(0.95) && error > legacy_mid) legacy_mid = error;
+  }
+
+  double max6 = sinusize_max_error<6>(0, fix16_one);
+  double max7 = sinusize_max_error<7>(0, fix16_one);
+  double mid6 = sinusize_max_error<6>(F16(0.05), F16(0.95));
+  double mid7 = sinusize_max_error<7>(F16(0.05), F16(0.95));
+
+  char msg[150];
+  snprintf(msg, sizeof(msg),
+    "Max error, full / [0.05..0.95]: legacy(512) %.4f / %.4f, 64: %.4f / %.4f, 128: %.4f / %.4f",
+    legacy_max, legacy_mid, max6, mid6, max7, mid7);
+  TEST_MESSAGE(msg);
+
+  TEST_ASSERT_TRUE(max6 <= legacy_max);
+  TEST_ASSERT_TRUE(max7 <= legacy_max);
+  TEST_ASSERT_TRUE(mid7 <= legacy_mid);
+}
+
+
 int main() {
   UNITY_BEGIN();
   RUN_TEST(test_fix16_div);
+  RUN_TEST(test_fix16_lut_identity);
+  RUN_TEST(test_fix16_lut_interpolation);
+  RUN_TEST(test_fix16_lut_inverse);
+  RUN_TEST(test_fix16_sinusize_table);
+  RUN_TEST(test_fix16_sinusize_precision);
   UNITY_END();
 }
 
@@ -0,0 +1,153 @@
+#ifdef UNIT_TEST
+
+#include <unity.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+
+#include "../src/fix16_math/fix16_math.h"
+#include "../src/fix16_math/fix_recip.h"
+
+
+static int32_t random_int32()
+{
+  return (int32_t)(((uint32_t)rand() << 16) ^ (uint32_t)rand());
+}
+
+// Exact quotient, rounded to -inf
+static int64_t quotient_reference(fix16_t x, fix16_t d)
+{
+  int64_t n = (int64_t)x * 65536;
+  int64_t q = n / d;
+  if ((n % d != 0) && ((n < 0) != (d < 0))) q--;
+  return q;
+}
+
+
+void test_fix_recip_simple() {
+  FixRecip r(F16(4));
+
+  TEST_ASSERT_INT_WITHIN(1, F16(0.25), r.div(fix16_one));
+  TEST_ASSERT_INT_WITHIN(1, F16(2.5), r.div(F16(10)));
+  TEST_ASSERT_INT_WITHIN(1, F16(-2.5), r.div(F16(-10)));
+
+  r.set(F16(-0.5));
+  TEST_ASSERT_INT_WITHIN(1, F16(-6), r.div(F16(3)));
+
+  r.set(0);
+  TEST_ASSERT_EQUAL(fix16_minimum, r.div(F16(3)));
+}
+
+
+void test_fix_recip_precision() {
+  srand(1);
+
+  int64_t max_error = 0;
+  int64_t max_excess = 0;
+
+  for (int i = 0; i < 1000000; i++)
+  {
+    fix16_t d = random_int32() >> (rand() % 31);
+    fix16_t x = random_int32() >> (rand() % 31);
+
+    if (d == 0) continue;
+
+    int64_t q = quotient_reference(x, d);
+
+    // Skip overflow
+    if (q > INT32_MAX || q < INT32_MIN) continue;
+
+    FixRecip r(d);
+    int64_t error = llabs(r.div(x) - q);
+    // Error above declared bound
+    int64_t excess = error - (2 + (llabs(q) >> 28));
+
+    if (error > max_error) max_error = error;
+    if (excess > max_excess) max_excess = excess;
+  }
+
+  char msg[100];
+  snprintf(msg, sizeof(msg), "Max error, LSB: %lld", (long long)max_error);
+  TEST_MESSAGE(msg);
+
+  TEST_ASSERT_EQUAL(0, max_excess);
+}
+
+
+// Typical case - R = V / I, with I in [0.01..10] A
+void test_fix_recip_r_ekv() {
+  srand(2);
+
+  int64_t max_error = 0;
+
+  for (int i = 0; i < 100000; i++)
+  {
+    fix16_t amps = F16(0.01) + rand() % F16(10);
+    fix16_t volts = rand() % F16(320);
+
+    if (quotient_reference(volts, amps) > INT32_MAX) continue;
+
+    int64_t error = llabs(FixRecip(amps).div(volts) - quotient_reference(volts, amps));
+    if (error > max_error) max_error = error;
+  }
+
+  TEST_ASSERT_TRUE(max_error <= 2);
+}
+
+
+void test_fix_recip_benchmark() {
+  const int len = 1024;
+  const int rounds = 200;
+  fix16_t x[len];
+  fix16_t d[len];
+
+  srand(3);
+  for (int i = 0; i < len; i++)
+  {
+    x[i] = rand() % F16(320);
+    d[i] = F16(0.01) + rand() % F16(10);
+  }
+
+  volatile fix16_t sink = 0;
+
+  // Same divisor for all data (cached reciprocal)
+  auto t0 = std::chrono::steady_clock::now();
+  for (int r = 0; r < rounds; r++)
+  {
+    for (int i = 0; i < len; i++) sink = sink + fix16_div(x[i], d[r]);
+  }
+  auto t1 = std::chrono::steady_clock::now();
+  for (int r = 0; r < rounds; r++)
+  {
+    FixRecip recip(d[r]);
+    for (int i = 0; i < len; i++) sink = sink + recip.div(x[i]);
+  }
+  auto t2 = std::chrono::steady_clock::now();
+  // New divisor every time (set + div)
+  for (int r = 0; r < rounds; r++)
+  {
+    for (int i = 0; i < len; i++) sink = sink + FixRecip(d[i]).div(x[i]);
+  }
+  auto t3 = std::chrono::steady_clock::now();
+
+  double n = (double)rounds * len;
+  char msg[120];
+  snprintf(msg, sizeof(msg), "ns per div: fix16_div %.2f, cached %.2f, set + div %.2f",
+    std::chrono::duration<double, std::nano>(t1 - t0).count() / n,
+    std::chrono::duration<double, std::nano>(t2 - t1).count() / n,
+    std::chrono::duration<double, std::nano>(t3 - t2).count() / n);
+  TEST_MESSAGE(msg);
+}
+
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_fix_recip_simple);
+  RUN_TEST(test_fix_recip_precision);
+  RUN_TEST(test_fix_recip_r_ekv);
+  RUN_TEST(test_fix_recip_benchmark);
+  UNITY_END();
+}
+
+
+#endif
@@ -0,0 +1,118 @@
+#ifdef UNIT_TEST
+
+#include <unity.h>
+#include <stdlib.h>
+
+#include "../src/fix16_math/fix16_math.h"
+#include "../src/fix16_math/fixed.h"
+
+
+typedef Fixed<16, 16> Q16;
+typedef Fixed<8, 24> Q24;
+typedef Fixed<4, 28> Q28;
+
+// Constants are evaluated at compile time
+static_assert(Fixed<16, 16>(1.5).raw == 0x18000, "constexpr construction");
+static_assert(Fixed<8, 24>(-0.25).raw == -(1 << 22), "constexpr construction");
+static_assert(Fixed<1, 31>(0.5).raw == (1 << 30), "constexpr construction");
+
+
+void test_fixed_construct() {
+  TEST_ASSERT_EQUAL(F16(0.3), Q16(0.3).raw);
+  TEST_ASSERT_EQUAL(F16(-12.7), Q16(-12.7).raw);
+  TEST_ASSERT_EQUAL(5 << 24, Q24::from_int(5).raw);
+  TEST_ASSERT_EQUAL(-3, Q16(-2.5).to_int());
+  TEST_ASSERT_EQUAL_FLOAT(0.125F, Q28(0.125).to_float());
+}
+
+
+void test_fixed_convert() {
+  Q24 a(1.0 / 450);
+  Q16 b = a.to<16, 16>();
+
+  // Narrowing fraction truncates
+  TEST_ASSERT_EQUAL(a.raw >> 8, b.raw);
+  TEST_ASSERT_EQUAL(F16(2.75), Q24(2.75).to_fix16());
+  TEST_ASSERT_EQUAL(Q24(-2.75).raw, Q24::from_fix16(F16(-2.75)).raw);
+
+  uint32_t overflows = fixed_overflow_count();
+  Q16(200.0).to<8, 24>();
+  TEST_ASSERT_EQUAL(overflows + 1, fixed_overflow_count());
+}
+
+
+void test_fixed_same_as_fix16() {
+  srand(1);
+
+  uint32_t overflows = fixed_overflow_count();
+
+  for (int i = 0; i < 10000; i++)
+  {
+    fix16_t a = (rand() % 0x1000000) - 0x800000;
+    fix16_t b = (rand() % 0x1000000) - 0x800000;
+
+    Q16 fa = Q16::from_raw(a);
+    Q16 fb = Q16::from_raw(b);
+
+    TEST_ASSERT_EQUAL(a + b, (fa + fb).raw);
+    TEST_ASSERT_EQUAL(a - b, (fa - fb).raw);
+    TEST_ASSERT_EQUAL(fix16_mul(a, b), (fa * fb).raw);
+
+    if (b && abs(a) < abs(b) * 0x4000) TEST_ASSERT_EQUAL(fix16_div(a, b), (fa / fb).raw);
+  }
+
+  TEST_ASSERT_EQUAL(overflows, fixed_overflow_count());
+}
+
+
+void test_fixed_mixed_formats() {
+  // fix16 is too coarse for small values, Q8.24 keeps precision
+  Q24 inv = Q24(1.0) / Q16(450.0);
+  Q16 r_ekv(225.0);
+
+  TEST_ASSERT_EQUAL(((int64_t)1 << 40) / F16(450), inv.raw);
+  TEST_ASSERT_EQUAL(F16(0.5) - 1, (r_ekv * inv).raw);
+  TEST_ASSERT_FLOAT_WITHIN(0.0001, 0.5F, (r_ekv * inv).to_float());
+
+  // fix16 result for comparison, error is much bigger
+  float fix16_result = fix16_to_float(fix16_mul(F16(225), fix16_div(fix16_one, F16(450))));
+  TEST_ASSERT_TRUE(fix16_result < 0.499F);
+}
+
+
+void test_fixed_overflow() {
+  uint32_t overflows = fixed_overflow_count();
+
+  Q24 a(100.0);
+
+  a + a;
+  TEST_ASSERT_EQUAL(overflows + 1, fixed_overflow_count());
+
+  a * Q16(2.0);
+  TEST_ASSERT_EQUAL(overflows + 2, fixed_overflow_count());
+
+  a / Q16(0.5);
+  TEST_ASSERT_EQUAL(overflows + 3, fixed_overflow_count());
+
+  a * 2;
+  TEST_ASSERT_EQUAL(overflows + 4, fixed_overflow_count());
+
+  // No overflow
+  a - a;
+  a * Q16(1.2);
+  TEST_ASSERT_EQUAL(overflows + 4, fixed_overflow_count());
+}
+
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_fixed_construct);
+  RUN_TEST(test_fixed_convert);
+  RUN_TEST(test_fixed_same_as_fix16);
+  RUN_TEST(test_fixed_mixed_formats);
+  RUN_TEST(test_fixed_overflow);
+  UNITY_END();
+}
+
+
+#endif
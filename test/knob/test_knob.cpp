@@ -0,0 +1,131 @@
+#ifdef UNIT_TEST
+
+#include <unity.h>
+
+#include "../src/knob.h"
+
+// One knob update (knob_decimation ticks) with constant 12-bit ADC value.
+// Returns number of ticks with `updated` flag set.
+static int feed(Knob &knob, int adc, int edges[2] = nullptr)
+{
+  int updates = 0;
+
+  for (int i = 0; i < knob_decimation; i++)
+  {
+    knob.tick(adc * ADC_FETCH_PER_TICK);
+
+    if (knob.updated) updates++;
+    if (edges && knob.edge_up) edges[0]++;
+    if (edges && knob.edge_down) edges[1]++;
+  }
+  return updates;
+}
+
+
+void test_knob_updated_once_per_block() {
+  Knob knob;
+
+  TEST_ASSERT_EQUAL(1, feed(knob, 2048));
+  TEST_ASSERT_EQUAL(1, feed(knob, 2048));
+  // Not configured => no smoothing, value is block mean
+  TEST_ASSERT_EQUAL(F16(0.5), knob.value);
+}
+
+
+void test_knob_quantization_hysteresis() {
+  Knob knob;
+
+  feed(knob, 2048);
+  TEST_ASSERT_EQUAL(F16(0.5), knob.value);
+
+  // 1 ADC count is 16 in fix16, quantization step is 64. Value changes
+  // only when filtered one moves for 2 steps (8 counts) or more.
+  feed(knob, 2048 + 7);
+  TEST_ASSERT_EQUAL(F16(0.5), knob.value);
+
+  feed(knob, 2048 + 8);
+  TEST_ASSERT_EQUAL(F16(0.5) + 2 * KNOB_QUANT_STEP, knob.value);
+
+  // The same down
+  feed(knob, 2048 + 8 - 7);
+  TEST_ASSERT_EQUAL(F16(0.5) + 2 * KNOB_QUANT_STEP, knob.value);
+
+  feed(knob, 2048);
+  TEST_ASSERT_EQUAL(F16(0.5), knob.value);
+
+  // Jitter within hysteresis is suppressed
+  for (int i = 0; i < 100; i++)
+  {
+    feed(knob, 2048 + (i & 1 ? 5 : -5));
+    TEST_ASSERT_EQUAL(F16(0.5), knob.value);
+  }
+}
+
+
+void test_knob_edges_fire_once() {
+  Knob knob;
+  int edges[2] = { 0, 0 };
+
+  // Slow ramp up, through "low" zone threshold
+  for (int adc = 0; adc <= 4095; adc += 8) feed(knob, adc, edges);
+
+  TEST_ASSERT_TRUE(knob.high);
+  TEST_ASSERT_EQUAL(1, edges[0]);
+  TEST_ASSERT_EQUAL(0, edges[1]);
+
+  // Ramp down
+  for (int adc = 4095; adc >= 0; adc -= 8) feed(knob, adc, edges);
+
+  TEST_ASSERT_FALSE(knob.high);
+  TEST_ASSERT_EQUAL(1, edges[0]);
+  TEST_ASSERT_EQUAL(1, edges[1]);
+}
+
+
+void test_knob_edges_no_chatter_at_threshold() {
+  Knob knob;
+  int edges[2] = { 0, 0 };
+
+  // Noise around threshold, within threshold hysteresis (0.05 +/- 0.008)
+  int threshold_adc = 4096 * 0.05;
+
+  for (int i = 0; i < 200; i++) feed(knob, threshold_adc + (i & 1 ? 32 : -32), edges);
+
+  TEST_ASSERT_EQUAL(0, edges[0]);
+  TEST_ASSERT_EQUAL(0, edges[1]);
+
+  // Go up - one edge, noise above - nothing more
+  for (int i = 0; i < 200; i++) feed(knob, threshold_adc + 64 + (i & 1 ? 32 : -32), edges);
+
+  TEST_ASSERT_EQUAL(1, edges[0]);
+  TEST_ASSERT_EQUAL(0, edges[1]);
+}
+
+
+void test_knob_smoothing() {
+  Knob knob;
+  knob.configure(0.02);
+
+  // 0.2s, ~ 10 time constants
+  for (int i = 0; i < APP_PID_FREQUENCY / 5; i++) feed(knob, 4000);
+
+  TEST_ASSERT_INT_WITHIN(KNOB_HYSTERESIS, F16(4000.0 / 4096), knob.value);
+
+  // First update after step is only partial
+  feed(knob, 0);
+  TEST_ASSERT_TRUE(knob.value > F16(0.5));
+}
+
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_knob_updated_once_per_block);
+  RUN_TEST(test_knob_quantization_hysteresis);
+  RUN_TEST(test_knob_edges_fire_once);
+  RUN_TEST(test_knob_edges_no_chatter_at_threshold);
+  RUN_TEST(test_knob_smoothing);
+  UNITY_END();
+}
+
+
+#endif
@@ -1,9 +1,14 @@
 #ifdef UNIT_TEST
 
 #include <unity.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <chrono>
 
 #include "../src/fix16_math/fix16_math.h"
 #include "../src/median.h"
+#include "median_legacy.h"
 
 // samples from `/doc/data`
 fix16_t data[] = {
@@ -141,6 +146,314 @@ void test_median_64() {
 }
 
 
+void test_median_spread() {
+  MedianIteratorTemplate<fix16_t, 64> m;
+
+  TEST_ASSERT_EQUAL(0, m.spread());
+
+  // 1..8, quartiles are 2.5 & 6.5
+  int order[] = { 5, 1, 8, 3, 7, 2, 6, 4 };
+  for (int i = 0; i < 8; i++) m.add(F16(order[i]));
+
+  TEST_ASSERT_EQUAL(8, m.count());
+  TEST_ASSERT_EQUAL(F16(4), m.spread());
+
+  // 1..9, quartiles are 2.5 & 7 (middle element went to high half)
+  m.add(F16(9));
+  TEST_ASSERT_EQUAL(F16(4.5), m.spread());
+}
+
+
+void test_median_float() {
+  MedianIteratorTemplate<float, 8> m;
+
+  // Fractional values should not be truncated in comparisons
+  m.add(0.3F);
+  m.add(0.1F);
+  m.add(0.7F);
+  m.add(0.2F);
+  m.add(0.9F);
+
+  TEST_ASSERT_EQUAL_FLOAT(0.3F, m.result());
+}
+
+
+void test_median_random() {
+  MedianIteratorTemplate<fix16_t, 64> m;
+  fix16_t sorted[64];
+
+  srand(1);
+
+  for (int round = 0; round < 100; round++)
+  {
+    m.reset();
+    int len = 1 + rand() % 64;
+
+    for (int i = 0; i < len; i++)
+    {
+      // Small range, to have duplicates
+      sorted[i] = (rand() % 50) - 25;
+      m.add(sorted[i]);
+    }
+
+    std::sort(sorted, sorted + len);
+
+    fix16_t expected = (len & 1) ? sorted[len / 2] :
+      (sorted[len / 2 - 1] + sorted[len / 2]) / 2;
+
+    TEST_ASSERT_EQUAL(expected, m.result());
+  }
+}
+
+
+template <typename Median>
+static double benchmark_fill(const fix16_t *src, int len)
+{
+  const int rounds = 2000;
+  volatile fix16_t sink = 0;
+  Median m;
+
+  auto t0 = std::chrono::steady_clock::now();
+  for (int r = 0; r < rounds; r++)
+  {
+    m.reset();
+    for (int i = 0; i < len; i++) m.add(src[i]);
+    sink = sink + m.result();
+  }
+  auto t1 = std::chrono::steady_clock::now();
+
+  return std::chrono::duration<double, std::nano>(t1 - t0).count() / rounds / len;
+}
+
+template <int SIZE>
+static void benchmark_size(const fix16_t *src)
+{
+  double ns_legacy = benchmark_fill<MedianLegacyTemplate<fix16_t, SIZE>>(src, SIZE);
+  double ns_heap = benchmark_fill<MedianHeapTemplate<fix16_t, SIZE>>(src, SIZE);
+
+  char msg[100];
+  snprintf(msg, sizeof(msg), "SIZE %3d, ns per add: legacy %.1f, heap %.1f",
+    SIZE, ns_legacy, ns_heap);
+  TEST_MESSAGE(msg);
+}
+
+void test_median_benchmark() {
+  fix16_t src[256];
+
+  // Noisy data, like R_ekv samples
+  srand(2);
+  for (int i = 0; i < 256; i++) src[i] = F16(0.5) + (rand() % 6554) - 3277;
+
+  benchmark_size<8>(src);
+  benchmark_size<16>(src);
+  benchmark_size<32>(src);
+  benchmark_size<64>(src);
+  benchmark_size<128>(src);
+  benchmark_size<256>(src);
+
+  // Overflow policies, 4x overflow
+  double ns_ignore = benchmark_fill<MedianHeapTemplate<fix16_t, 32>>(src, 128);
+  double ns_reservoir = benchmark_fill<MedianHeapTemplate<fix16_t, 32,
+    MEDIAN_OVERFLOW_RESERVOIR>>(src, 128);
+  double ns_decimate = benchmark_fill<MedianHeapTemplate<fix16_t, 32,
+    MEDIAN_OVERFLOW_DECIMATE>>(src, 128);
+
+  char msg[100];
+  snprintf(msg, sizeof(msg), "SIZE 32 x4 overflow, ns per add: ignore %.1f, reservoir %.1f, decimate %.1f",
+    ns_ignore, ns_reservoir, ns_decimate);
+  TEST_MESSAGE(msg);
+}
+
+
+// 0-1 principle: network sorts everything, if it sorts all 0/1 sequences
+template <int N>
+static void check_network_01()
+{
+  for (uint32_t bits = 0; bits < (1U << N); bits++)
+  {
+    int data[N];
+    for (int i = 0; i < N; i++) data[i] = (bits >> i) & 1;
+
+    sorting_network::sort<int, N>(data);
+
+    for (int i = 1; i < N; i++) TEST_ASSERT_TRUE(data[i - 1] <= data[i]);
+  }
+}
+
+void test_sorting_network() {
+  TEST_ASSERT_EQUAL(3, sorting_network::size(3));
+  TEST_ASSERT_EQUAL(9, sorting_network::size(5));
+  TEST_ASSERT_EQUAL(63, sorting_network::size(16));
+
+  check_network_01<2>();
+  check_network_01<3>();
+  check_network_01<4>();
+  check_network_01<5>();
+  check_network_01<7>();
+  check_network_01<8>();
+  check_network_01<9>();
+  check_network_01<13>();
+  check_network_01<16>();
+}
+
+
+// Network & heaps should give the same results for any data count
+template <int SIZE>
+static void check_network_vs_heap()
+{
+  for (int round = 0; round < 50; round++)
+  {
+    MedianNetworkTemplate<fix16_t, SIZE> network;
+    MedianHeapTemplate<fix16_t, SIZE> heap;
+    int len = rand() % (SIZE + 3);
+
+    for (int i = 0; i < len; i++)
+    {
+      fix16_t val = (rand() % 20) << 10;
+      network.add(val);
+      heap.add(val);
+
+      // Result between adds sorts network data in place, should not break it
+      if (i % 4 == 0) TEST_ASSERT_EQUAL(heap.result(), network.result());
+    }
+
+    TEST_ASSERT_EQUAL(heap.count(), network.count());
+    TEST_ASSERT_EQUAL(heap.result(), network.result());
+  }
+}
+
+void test_median_network() {
+  srand(3);
+
+  check_network_vs_heap<3>();
+  check_network_vs_heap<5>();
+  check_network_vs_heap<7>();
+  check_network_vs_heap<9>();
+  check_network_vs_heap<16>();
+
+  MedianNetworkTemplate<fix16_t, 9> m;
+  for (int i = 8; i > 0; i--) m.add(F16(i));
+  TEST_ASSERT_EQUAL(F16(4), m.spread());
+
+  // Auto selection
+  TEST_ASSERT_TRUE((std::is_same<MedianIteratorTemplate<fix16_t, 16>,
+    MedianNetworkTemplate<fix16_t, 16>>::value));
+  TEST_ASSERT_TRUE((std::is_same<MedianIteratorTemplate<fix16_t, 17>,
+    MedianHeapTemplate<fix16_t, 17>>::value));
+}
+
+
+template <int SIZE>
+static void benchmark_network_size(const fix16_t *src)
+{
+  double ns_heap = benchmark_fill<MedianHeapTemplate<fix16_t, SIZE>>(src, SIZE);
+  double ns_network = benchmark_fill<MedianNetworkTemplate<fix16_t, SIZE>>(src, SIZE);
+
+  char msg[100];
+  snprintf(msg, sizeof(msg), "SIZE %3d, ns per sample: heap %.1f, network %.1f",
+    SIZE, ns_heap, ns_network);
+  TEST_MESSAGE(msg);
+}
+
+void test_median_network_benchmark() {
+  fix16_t src[16];
+
+  srand(4);
+  for (int i = 0; i < 16; i++) src[i] = F16(0.5) + (rand() % 6554) - 3277;
+
+  benchmark_network_size<3>(src);
+  benchmark_network_size<5>(src);
+  benchmark_network_size<7>(src);
+  benchmark_network_size<9>(src);
+  benchmark_network_size<16>(src);
+}
+
+
+// Slow ramp, 0..len-1, with noise. Median of all data is ~ len/2, while
+// median of the first SIZE values is ~ SIZE/2.
+template <typename Median>
+static fix16_t fill_ramp(Median &m, int len)
+{
+  srand(5);
+  for (int i = 0; i < len; i++) m.add(F16(i) + (rand() % 10000) - 5000);
+  return m.result();
+}
+
+// Reservoir result is random, use average of several runs
+template <typename Median>
+static float fill_ramp_average(Median &m, int len)
+{
+  float sum = 0;
+
+  for (int i = 0; i < 20; i++)
+  {
+    m.reset();
+    sum += fix16_to_float(fill_ramp(m, len));
+  }
+
+  return sum / 20;
+}
+
+void test_median_overflow_policy() {
+  MedianHeapTemplate<fix16_t, 32> ignore;
+  MedianHeapTemplate<fix16_t, 32, MEDIAN_OVERFLOW_RESERVOIR> reservoir;
+  MedianHeapTemplate<fix16_t, 32, MEDIAN_OVERFLOW_DECIMATE> decimate;
+
+  TEST_ASSERT_FLOAT_WITHIN(1, 16, fix16_to_float(fill_ramp(ignore, 100)));
+  TEST_ASSERT_FLOAT_WITHIN(3, 50, fix16_to_float(fill_ramp(decimate, 100)));
+  TEST_ASSERT_FLOAT_WITHIN(5, 50, fill_ramp_average(reservoir, 100));
+
+  TEST_ASSERT_EQUAL(32, ignore.count());
+  TEST_ASSERT_EQUAL(32, reservoir.count());
+  TEST_ASSERT_TRUE(decimate.count() <= 32);
+
+  // Long series
+  decimate.reset();
+  TEST_ASSERT_FLOAT_WITHIN(30, 500, fix16_to_float(fill_ramp(decimate, 1000)));
+  TEST_ASSERT_FLOAT_WITHIN(50, 500, fill_ramp_average(reservoir, 1000));
+}
+
+
+// After overflow, stored data should still give exact median of itself
+void test_median_overflow_policy_consistency() {
+  MedianHeapTemplate<fix16_t, 16, MEDIAN_OVERFLOW_RESERVOIR> m;
+
+  srand(6);
+  for (int i = 0; i < 500; i++)
+  {
+    m.add((rand() % 1000) << 8);
+    TEST_ASSERT_TRUE(m.count() <= 16);
+  }
+
+  // Heaps are valid, if lowest quartile is not above highest one
+  TEST_ASSERT_TRUE(m.spread() >= 0);
+}
+
+
+// Decimation is finished lazily. Reading result between the steps should
+// not change data kept.
+void test_median_decimate_split() {
+  MedianHeapTemplate<fix16_t, 32, MEDIAN_OVERFLOW_DECIMATE> polled;
+  MedianHeapTemplate<fix16_t, 32, MEDIAN_OVERFLOW_DECIMATE> silent;
+
+  srand(7);
+  for (int i = 0; i < 300; i++)
+  {
+    fix16_t val = (rand() % 1000) << 8;
+
+    polled.add(val);
+    silent.add(val);
+
+    TEST_ASSERT_TRUE(polled.count() <= 32);
+    TEST_ASSERT_TRUE(polled.spread() >= 0);
+  }
+
+  TEST_ASSERT_EQUAL(silent.result(), polled.result());
+  TEST_ASSERT_EQUAL(silent.spread(), polled.spread());
+  TEST_ASSERT_EQUAL(silent.count(), polled.count());
+}
+
+
 int main() {
   UNITY_BEGIN();
   RUN_TEST(test_median_0_el);
@@ -151,6 +464,16 @@ int main() {
   RUN_TEST(test_median_5_el);
   RUN_TEST(test_median_overflow);
   RUN_TEST(test_median_64);
+  RUN_TEST(test_median_spread);
+  RUN_TEST(test_median_float);
+  RUN_TEST(test_median_random);
+  RUN_TEST(test_median_benchmark);
+  RUN_TEST(test_sorting_network);
+  RUN_TEST(test_median_network);
+  RUN_TEST(test_median_network_benchmark);
+  RUN_TEST(test_median_overflow_policy);
+  RUN_TEST(test_median_overflow_policy_consistency);
+  RUN_TEST(test_median_decimate_split);
   UNITY_END();
 }
 
@@ -0,0 +1,169 @@
+#ifdef UNIT_TEST
+
+#include <unity.h>
+
+#include "../src/fix16_math/fix16_math.h"
+#include "../src/motor_model_fit.h"
+#include "../motor_sim.h"
+
+
+static void replay(MotorModelFit &fit, const MotorSimHalfWave &hw, bool standstill,
+  fix16_t r_ekv_ref = F16(-1))
+{
+  int triac_on_counter = 0;
+
+  fit.reset();
+
+  for (int t = 1; t < hw.ticks; t++)
+  {
+    if (hw.triac_on[t]) triac_on_counter++;
+
+    if ((triac_on_counter > 3) && (hw.voltage[t] > 0) && (t >= hw.ticks / 2))
+    {
+      fit.add(hw.voltage[t], hw.current[t], hw.current[t] - hw.current[t - 1]);
+    }
+  }
+
+  fit.update(standstill, r_ekv_ref);
+}
+
+static void configure(MotorModelFit &fit, const MotorSimParams &p, float r, float l)
+{
+  fit.configure(
+    fix16_from_float(r),
+    fix16_from_float(l),
+    fix16_from_float(motor_sim_kv(p) / motor_sim_ki(p))
+  );
+}
+
+
+void test_fit_tracks_inductance() {
+  MotorSimParams p;
+  MotorSimHalfWave hw;
+  MotorModelFit fit;
+
+  p.l = 0.2;
+  configure(fit, p, p.r, 0.1);
+
+  for (int i = 0; i < 30; i++)
+  {
+    motor_sim_half_wave(p, hw);
+    replay(fit, hw, false);
+  }
+
+  TEST_ASSERT_FLOAT_WITHIN(0.02, p.l, fix16_to_float(fit.l));
+  TEST_ASSERT_FLOAT_WITHIN(p.r_ekv * 0.03, p.r_ekv, fix16_to_float(fit.result()));
+}
+
+
+void test_fit_noisy_data() {
+  MotorSimParams p;
+  MotorSimHalfWave hw;
+  MotorModelFit fit;
+
+  p.noise = 2;
+  configure(fit, p, p.r, p.l);
+
+  for (int i = 0; i < 30; i++)
+  {
+    motor_sim_half_wave(p, hw);
+    replay(fit, hw, false);
+  }
+
+  TEST_ASSERT_FLOAT_WITHIN(0.03, p.l, fix16_to_float(fit.l));
+  TEST_ASSERT_FLOAT_WITHIN(p.r_ekv * 0.05, p.r_ekv, fix16_to_float(fit.result()));
+}
+
+
+void test_fit_tracks_warm_resistance() {
+  MotorSimParams p;
+  MotorSimHalfWave hw;
+  MotorModelFit fit;
+
+  // Winding warmed up by 15%
+  configure(fit, p, p.r, p.l);
+  p.r *= 1.15;
+
+  // Motor start from standstill
+  p.r_ekv = 0;
+  motor_sim_half_wave(p, hw);
+  replay(fit, hw, true);
+
+  TEST_ASSERT_FLOAT_WITHIN(p.r * 0.03, p.r, fix16_to_float(fit.r));
+
+  // Now rotating
+  p.r_ekv = 200;
+  for (int i = 0; i < 5; i++)
+  {
+    motor_sim_half_wave(p, hw);
+    replay(fit, hw, false);
+  }
+
+  TEST_ASSERT_FLOAT_WITHIN(p.r_ekv * 0.03, p.r_ekv, fix16_to_float(fit.result()));
+}
+
+
+void test_fit_tracks_resistance_while_running() {
+  MotorSimParams p;
+  MotorSimHalfWave hw;
+  MotorModelFit fit;
+
+  configure(fit, p, p.r, p.l);
+  p.noise = 2;
+
+  // Winding heats up by 20% in continuous run, without stops. R_ekv
+  // reference (by ripple) has random error ~ 3%.
+  float r_cold = p.r;
+  uint32_t rand_state = 1;
+
+  for (int i = 0; i < 3000; i++)
+  {
+    p.r = r_cold * (i < 2000 ? 1 + 0.2 * i / 2000 : 1.2);
+
+    rand_state = rand_state * 1103515245 + 12345;
+    float ref_error = ((float)((rand_state >> 16) & 0x7FFF) / 0x7FFF * 2 - 1) * 0.03;
+
+    motor_sim_half_wave(p, hw);
+    replay(fit, hw, false, fix16_from_float(p.r_ekv * (1 + ref_error)));
+  }
+
+  TEST_ASSERT_FLOAT_WITHIN(p.r * 0.03, p.r, fix16_to_float(fit.r));
+  TEST_ASSERT_FLOAT_WITHIN(p.r_ekv * 0.03, p.r_ekv, fix16_to_float(fit.result()));
+}
+
+
+void test_fit_rejects_r_total_overflow() {
+  MotorSimParams p;
+  MotorSimHalfWave hw;
+  MotorModelFit fit;
+
+  configure(fit, p, p.r, p.l);
+  motor_sim_half_wave(p, hw);
+  replay(fit, hw, false);
+
+  fix16_t r_total = fit.r_total;
+
+  // Full voltage with almost zero current - R_total is above fix16 range
+  fit.reset();
+  for (int t = 0; t < 10; t++) fit.add(4000, 1, 0);
+
+  TEST_ASSERT_EQUAL(fix16_maximum, fit.partial_result());
+
+  fit.update(false);
+
+  TEST_ASSERT_EQUAL(r_total, fit.r_total);
+}
+
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_fit_tracks_inductance);
+  RUN_TEST(test_fit_noisy_data);
+  RUN_TEST(test_fit_tracks_warm_resistance);
+  RUN_TEST(test_fit_tracks_resistance_while_running);
+  RUN_TEST(test_fit_rejects_r_total_overflow);
+  UNITY_END();
+}
+
+
+#endif
@@ -0,0 +1,101 @@
+#ifndef __TEST_MOTOR_SIM__
+#define __TEST_MOTOR_SIM__
+
+// Synthetic motor waveforms for host tests. Emulates positive half-wave of
+// mains voltage, applied to motor via triac, and returns raw ADC data, as
+// Sensors would see it after oversampling filter.
+//
+//   V = (R + R_ekv) * I + L * dI/dt
+
+#include <math.h>
+#include <stdint.h>
+
+#include "../src/app.h"
+
+// Half-wave length for 50Hz mains
+#define MOTOR_SIM_MAX_TICKS (APP_TICK_FREQUENCY / 100 + 2)
+
+struct MotorSimParams
+{
+  float r = 140.0F;       // motor resistance, Ohm
+  float l = 0.15F;        // motor inductance, H
+  float r_ekv = 200.0F;   // back-EMF equivalent resistance, Ohm
+  float v_amplitude = 325.0F;
+  float mains_freq = 50.0F;
+  float fire_phase = 0.2F; // triac opening, [0.0..1.0) of half-wave
+  float v_ref = 3.3F;
+  float shunt = 0.01F * 50; // shunt resistance * amplifier gain
+  int noise = 0;          // ADC noise amplitude, counts
+  // Commutator ripple, relative to current, and it's frequency (Hz)
+  float ripple = 0.0F;
+  float ripple_freq = 0.0F;
+};
+
+struct MotorSimHalfWave
+{
+  int ticks;
+  uint16_t voltage[MOTOR_SIM_MAX_TICKS];
+  uint16_t current[MOTOR_SIM_MAX_TICKS];
+  bool triac_on[MOTOR_SIM_MAX_TICKS];
+};
+
+// Volts / amperes per ADC count
+static inline float motor_sim_kv(const MotorSimParams &p) { return p.v_ref * 201.0F / 4096; }
+static inline float motor_sim_ki(const MotorSimParams &p) { return p.v_ref / p.shunt / 4096; }
+
+static uint32_t motor_sim_rand_state = 12345;
+
+static inline int motor_sim_noise(int amplitude)
+{
+  if (!amplitude) return 0;
+  motor_sim_rand_state = motor_sim_rand_state * 1103515245 + 12345;
+  return (int)((motor_sim_rand_state >> 16) % (2 * amplitude + 1)) - amplitude;
+}
+
+static inline uint16_t motor_sim_adc(float val, int noise)
+{
+  int adc = (int)(val + 0.5F) + motor_sim_noise(noise);
+  if (adc < 0) return 0;
+  if (adc > 4095) return 4095;
+  return adc;
+}
+
+// Fill one positive half-wave. Current starts from zero.
+static inline void motor_sim_half_wave(const MotorSimParams &p, MotorSimHalfWave &out)
+{
+  const int substeps = 16;
+  const float dt = 1.0F / APP_TICK_FREQUENCY / substeps;
+  const float w = 2 * M_PI * p.mains_freq;
+  const int ticks = (int)(APP_TICK_FREQUENCY / p.mains_freq / 2);
+  const int fire_tick = (int)(p.fire_phase * ticks);
+
+  float i = 0;
+  float t = 0;
+
+  out.ticks = ticks;
+
+  for (int tick = 0; tick < ticks; tick++)
+  {
+    bool on = tick >= fire_tick;
+
+    for (int s = 0; s < substeps; s++)
+    {
+      float v = p.v_amplitude * sinf(w * t);
+      if (on) i += (v - (p.r + p.r_ekv) * i) / p.l * dt;
+      if (i < 0) i = 0;
+      t += dt;
+    }
+
+    float v = p.v_amplitude * sinf(w * t);
+    float i_measured = i;
+
+    if (p.ripple > 0) i_measured *= 1.0F + p.ripple * sinf(2 * M_PI * p.ripple_freq * t);
+
+    // Last tick of half-wave - make sure voltage is zero
+    out.voltage[tick] = (tick == ticks - 1) ? 0 : motor_sim_adc(v / motor_sim_kv(p), p.noise);
+    out.current[tick] = motor_sim_adc(i_measured / motor_sim_ki(p), p.noise);
+    out.triac_on[tick] = on;
+  }
+}
+
+#endif
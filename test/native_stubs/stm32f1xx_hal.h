@@ -0,0 +1,43 @@
+#ifndef __NATIVE_STUBS_STM32F1XX_HAL__
+#define __NATIVE_STUBS_STM32F1XX_HAL__
+
+// Minimal HAL replacement, to test modules with hardware access on host.
+// GPIO writes are ignored, flash is emulated with RAM buffer.
+
+#include <stdint.h>
+#include <string.h>
+
+#define GPIOA ((void *)0)
+#define GPIO_PIN_8 8
+#define GPIO_PIN_SET 1
+#define GPIO_PIN_RESET 0
+
+static inline void HAL_GPIO_WritePin(void *, int, int) {}
+
+#define FLASH_PAGE_SIZE 1024
+#define FLASH_TYPEERASE_PAGES 0
+#define FLASH_TYPEPROGRAM_HALFWORD 1
+
+static uint8_t native_stubs_flash[64 * 1024];
+#define FLASH_BASE ((uintptr_t)native_stubs_flash)
+
+typedef struct {
+  uint32_t TypeErase;
+  uintptr_t PageAddress;
+  uint32_t NbPages;
+} FLASH_EraseInitTypeDef;
+
+static inline void HAL_FLASH_Unlock() {}
+static inline void HAL_FLASH_Lock() {}
+
+static inline void HAL_FLASHEx_Erase(FLASH_EraseInitTypeDef *init, uint32_t *)
+{
+  memset((void *)init->PageAddress, 0xFF, init->NbPages * FLASH_PAGE_SIZE);
+}
+
+static inline void HAL_FLASH_Program(int, uintptr_t addr, uint64_t data)
+{
+  *(uint16_t *)addr = (uint16_t)data;
+}
+
+#endif
@@ -0,0 +1,99 @@
+#ifdef UNIT_TEST
+
+#include <unity.h>
+#include <stdlib.h>
+
+#include "../src/fix16_math/fix16_math.h"
+#include "../src/p2_quantile.h"
+
+
+static float uniform() { return (float)rand() / RAND_MAX; }
+
+
+void test_p2_empty() {
+  P2Quantile<float> q;
+
+  TEST_ASSERT_EQUAL_FLOAT(0.0F, q.result());
+}
+
+
+void test_p2_few_samples() {
+  P2Quantile<float> q;
+
+  // Exact median for less than 5 samples
+  q.add(3.0F);
+  TEST_ASSERT_EQUAL_FLOAT(3.0F, q.result());
+  q.add(1.0F);
+  TEST_ASSERT_EQUAL_FLOAT(2.0F, q.result());
+  q.add(8.0F);
+  TEST_ASSERT_EQUAL_FLOAT(3.0F, q.result());
+  q.add(4.0F);
+  TEST_ASSERT_EQUAL_FLOAT(3.5F, q.result());
+  q.add(0.0F);
+  TEST_ASSERT_EQUAL_FLOAT(3.0F, q.result());
+}
+
+
+void test_p2_uniform() {
+  P2Quantile<float> p10(0.1F);
+  P2Quantile<float> p50(0.5F);
+  P2Quantile<float> p90(0.9F);
+
+  srand(1);
+
+  for (int i = 0; i < 10000; i++)
+  {
+    float x = uniform();
+    p10.add(x);
+    p50.add(x);
+    p90.add(x);
+  }
+
+  TEST_ASSERT_EQUAL(10000, p50.count());
+  TEST_ASSERT_FLOAT_WITHIN(0.02, 0.1, p10.result());
+  TEST_ASSERT_FLOAT_WITHIN(0.02, 0.5, p50.result());
+  TEST_ASSERT_FLOAT_WITHIN(0.02, 0.9, p90.result());
+}
+
+
+void test_p2_outliers() {
+  P2Quantile<float> q;
+
+  srand(2);
+
+  // Noisy data around 0.15 with 10% of big outliers, like inductance samples
+  for (int i = 0; i < 300; i++)
+  {
+    float x = 0.15F + (uniform() - 0.5F) * 0.02F;
+    if (i % 10 == 0) x = 100.0F * (uniform() - 0.5F);
+    q.add(x);
+  }
+
+  // Outliers should be rejected, result should stay inside noise band
+  TEST_ASSERT_FLOAT_WITHIN(0.01, 0.15, q.result());
+}
+
+
+void test_p2_fix16() {
+  P2Quantile<fix16_t> q;
+
+  srand(3);
+
+  for (int i = 0; i < 1000; i++) q.add(fix16_from_float(0.4F + uniform() * 0.2F));
+
+  TEST_ASSERT_FLOAT_WITHIN(0.01, 0.5, fix16_to_float(q.result()));
+}
+
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_p2_empty);
+  RUN_TEST(test_p2_few_samples);
+  RUN_TEST(test_p2_uniform);
+  RUN_TEST(test_p2_outliers);
+  RUN_TEST(test_p2_fix16);
+  UNITY_END();
+}
+
+
+#endif
@@ -0,0 +1,138 @@
+#ifdef UNIT_TEST
+
+#include <unity.h>
+#include <stdio.h>
+#include <chrono>
+
+#include "../src/fix16_math/fix16_math.h"
+#include "../src/median.h"
+#include "../src/rekv_sum_estimator.h"
+#include "../motor_sim.h"
+
+// Replay synthetic half-waves through both R_ekv estimators:
+//
+// - median of pointwise R_ekv (as in Sensors, with 3 divisions per tick)
+// - least squares over window sums (RekvSumEstimator)
+
+
+// Measurement window, the same as in `Sensors::speed_tick()`
+static bool in_window(const MotorSimHalfWave &hw, int tick, int triac_on_counter)
+{
+  return (triac_on_counter > 3) && (hw.voltage[tick] > 0) && (tick >= hw.ticks / 2);
+}
+
+static fix16_t replay_median(const MotorSimParams &p, const MotorSimHalfWave &hw)
+{
+  MedianIteratorTemplate<fix16_t, 32> median;
+  fix16_t kv = fix16_from_float(motor_sim_kv(p) * 4096);
+  fix16_t ki = fix16_from_float(motor_sim_ki(p) * 4096);
+  fix16_t r = fix16_from_float(p.r);
+  fix16_t l = fix16_from_float(p.l);
+  int triac_on_counter = 0;
+
+  for (int t = 1; t < hw.ticks; t++)
+  {
+    if (hw.triac_on[t]) triac_on_counter++;
+
+    if (!in_window(hw, t, triac_on_counter)) continue;
+
+    fix16_t voltage = fix16_mul(hw.voltage[t] << 4, kv);
+    fix16_t current = fix16_mul(hw.current[t] << 4, ki);
+    fix16_t di_dt = fix16_mul((hw.current[t] - hw.current[t - 1]) << 4, ki) * APP_TICK_FREQUENCY;
+
+    median.add(fix16_div(voltage, current) - r - fix16_div(fix16_mul(l, di_dt), current));
+  }
+
+  return median.result();
+}
+
+static fix16_t replay_sums(const MotorSimParams &p, const MotorSimHalfWave &hw)
+{
+  RekvSumEstimator estimator;
+  estimator.configure(
+    fix16_from_float(p.r),
+    fix16_from_float(p.l),
+    fix16_from_float(motor_sim_kv(p) / motor_sim_ki(p))
+  );
+  int triac_on_counter = 0;
+
+  for (int t = 1; t < hw.ticks; t++)
+  {
+    if (hw.triac_on[t]) triac_on_counter++;
+
+    if (!in_window(hw, t, triac_on_counter)) continue;
+
+    estimator.add(hw.voltage[t], hw.current[t], hw.current[t] - hw.current[t - 1]);
+  }
+
+  return estimator.result();
+}
+
+
+void test_sums_clean_data() {
+  MotorSimParams p;
+  MotorSimHalfWave hw;
+
+  for (float r_ekv = 100; r_ekv <= 500; r_ekv += 100)
+  {
+    p.r_ekv = r_ekv;
+    motor_sim_half_wave(p, hw);
+    TEST_ASSERT_FLOAT_WITHIN(r_ekv * 0.03, r_ekv, fix16_to_float(replay_sums(p, hw)));
+  }
+}
+
+
+void test_sums_vs_median_noisy_data() {
+  MotorSimParams p;
+  MotorSimHalfWave hw;
+  p.noise = 2;
+
+  for (float fire = 0.0; fire < 0.5; fire += 0.1)
+  {
+    p.fire_phase = fire;
+    motor_sim_half_wave(p, hw);
+
+    float sums = fix16_to_float(replay_sums(p, hw));
+    float median = fix16_to_float(replay_median(p, hw));
+
+    // Sums should be not worse than median of pointwise data
+    TEST_ASSERT_FLOAT_WITHIN(p.r_ekv * 0.05, p.r_ekv, sums);
+    TEST_ASSERT_TRUE(fabsf(sums - p.r_ekv) <= fabsf(median - p.r_ekv) + p.r_ekv * 0.01);
+  }
+}
+
+
+void test_sums_cost() {
+  MotorSimParams p;
+  MotorSimHalfWave hw;
+  p.noise = 2;
+  motor_sim_half_wave(p, hw);
+
+  const int rounds = 2000;
+  volatile fix16_t sink = 0;
+
+  auto t0 = std::chrono::steady_clock::now();
+  for (int i = 0; i < rounds; i++) sink = sink + replay_median(p, hw);
+  auto t1 = std::chrono::steady_clock::now();
+  for (int i = 0; i < rounds; i++) sink = sink + replay_sums(p, hw);
+  auto t2 = std::chrono::steady_clock::now();
+
+  double ns_median = std::chrono::duration<double, std::nano>(t1 - t0).count() / rounds;
+  double ns_sums = std::chrono::duration<double, std::nano>(t2 - t1).count() / rounds;
+
+  char msg[100];
+  snprintf(msg, sizeof(msg), "Half-wave replay, ns: median %.0f, sums %.0f", ns_median, ns_sums);
+  TEST_MESSAGE(msg);
+}
+
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_sums_clean_data);
+  RUN_TEST(test_sums_vs_median_noisy_data);
+  RUN_TEST(test_sums_cost);
+  UNITY_END();
+}
+
+
+#endif
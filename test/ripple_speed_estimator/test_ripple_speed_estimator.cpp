@@ -0,0 +1,112 @@
+#ifdef UNIT_TEST
+
+#include <unity.h>
+#include <stdio.h>
+
+#include "../src/fix16_math/fix16_math.h"
+#include "../src/ripple_speed_estimator.h"
+#include "../motor_sim.h"
+
+// Ripple frequency at max speed: 30000 rpm, 12 ripples per revolution
+#define RIPPLE_MAX_FREQ 6000.0F
+
+
+// Replay half-wave with the same window as in `Sensors::speed_tick()`
+static fix16_t replay(RippleSpeedEstimator &estimator, const MotorSimHalfWave &hw)
+{
+  int triac_on_counter = 0;
+
+  estimator.reset();
+
+  for (int t = 0; t < hw.ticks; t++)
+  {
+    if (hw.triac_on[t]) triac_on_counter++;
+
+    if ((triac_on_counter > 3) && (hw.voltage[t] > 0) && (t >= hw.ticks / 2))
+    {
+      estimator.add(hw.current[t]);
+    }
+  }
+
+  return estimator.result();
+}
+
+
+void test_ripple_speed_range() {
+  RippleSpeedEstimator estimator;
+  MotorSimParams p;
+  MotorSimHalfWave hw;
+
+  estimator.configure(RIPPLE_MAX_FREQ, 0.2F);
+  p.noise = 2;
+  p.ripple = 0.05F;
+
+  for (float speed = 0.25F; speed <= 1.0F; speed += 0.05F)
+  {
+    p.ripple_freq = RIPPLE_MAX_FREQ * speed;
+    motor_sim_half_wave(p, hw);
+
+    TEST_ASSERT_FLOAT_WITHIN(0.01, speed, fix16_to_float(replay(estimator, hw)));
+  }
+}
+
+
+// Worst case for bank - ripple exactly midway between two bins
+void test_ripple_between_bins() {
+  RippleSpeedEstimator estimator;
+  MotorSimParams p;
+  MotorSimHalfWave hw;
+
+  const float min_speed = 0.2F;
+  const float bin_step = (1.0F - min_speed) / (RIPPLE_BANK_SIZE - 1);
+
+  estimator.configure(RIPPLE_MAX_FREQ, min_speed);
+  p.noise = 2;
+  p.ripple = 0.05F;
+
+  for (int k = 0; k < RIPPLE_BANK_SIZE - 1; k++)
+  {
+    float speed = min_speed + bin_step * (k + 0.5F);
+
+    p.ripple_freq = RIPPLE_MAX_FREQ * speed;
+    motor_sim_half_wave(p, hw);
+
+    TEST_ASSERT_FLOAT_WITHIN(0.01, speed, fix16_to_float(replay(estimator, hw)));
+  }
+}
+
+
+void test_ripple_not_found() {
+  RippleSpeedEstimator estimator;
+  MotorSimParams p;
+  MotorSimHalfWave hw;
+
+  estimator.configure(RIPPLE_MAX_FREQ, 0.2F);
+  p.noise = 2;
+  motor_sim_half_wave(p, hw);
+
+  TEST_ASSERT_EQUAL_INT(RIPPLE_NOT_FOUND, replay(estimator, hw));
+}
+
+
+void test_ripple_too_few_samples() {
+  RippleSpeedEstimator estimator;
+
+  estimator.configure(RIPPLE_MAX_FREQ, 0.2F);
+  for (int i = 0; i < RIPPLE_MIN_SAMPLES - 1; i++) estimator.add(1000 + (i & 1) * 50);
+
+  TEST_ASSERT_EQUAL_INT(RIPPLE_NOT_FOUND, estimator.result());
+}
+
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_ripple_speed_range);
+  RUN_TEST(test_ripple_between_bins);
+  RUN_TEST(test_ripple_not_found);
+  RUN_TEST(test_ripple_too_few_samples);
+  UNITY_END();
+}
+
+
+#endif
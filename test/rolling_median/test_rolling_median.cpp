@@ -0,0 +1,118 @@
+#ifdef UNIT_TEST
+
+#include <unity.h>
+#include <stdlib.h>
+#include <algorithm>
+
+#include "../src/fix16_math/fix16_math.h"
+#include "../src/rolling_median.h"
+
+
+// Reference: sort last `len` samples
+static fix16_t median_of(const fix16_t *src, int len)
+{
+  fix16_t tmp[64];
+  std::copy(src, src + len, tmp);
+  std::sort(tmp, tmp + len);
+
+  return (len & 1) ? tmp[len / 2] : (tmp[len / 2 - 1] + tmp[len / 2]) / 2;
+}
+
+
+void test_rolling_median_empty() {
+  RollingMedian<fix16_t, 8> m;
+
+  TEST_ASSERT_EQUAL(0, m.result());
+  TEST_ASSERT_EQUAL(0, m.count());
+}
+
+
+void test_rolling_median_fill() {
+  RollingMedian<fix16_t, 8> m;
+
+  m.add(F16(3));
+  TEST_ASSERT_EQUAL(F16(3), m.result());
+  m.add(F16(1));
+  TEST_ASSERT_EQUAL(F16(2), m.result());
+  m.add(F16(2));
+  TEST_ASSERT_EQUAL(F16(2), m.result());
+}
+
+
+void test_rolling_median_window() {
+  RollingMedian<fix16_t, 5> m;
+
+  // Old samples should leave window
+  for (int i = 0; i < 5; i++) m.add(F16(100));
+  for (int i = 0; i < 5; i++) m.add(F16(i));
+
+  TEST_ASSERT_EQUAL(5, m.count());
+  TEST_ASSERT_EQUAL(F16(2), m.result());
+}
+
+
+void test_rolling_median_random() {
+  fix16_t history[1000];
+
+  srand(1);
+
+  for (int i = 0; i < 1000; i++)
+  {
+    // Small range, to have duplicates, and a slow trend
+    history[i] = (rand() % 50) + i / 10;
+  }
+
+  RollingMedian<fix16_t, 32> m32;
+  RollingMedian<fix16_t, 33> m33;
+
+  for (int i = 0; i < 1000; i++)
+  {
+    m32.add(history[i]);
+    m33.add(history[i]);
+
+    int len32 = std::min(i + 1, 32);
+    int len33 = std::min(i + 1, 33);
+
+    TEST_ASSERT_EQUAL(median_of(history + i + 1 - len32, len32), m32.result());
+    TEST_ASSERT_EQUAL(median_of(history + i + 1 - len33, len33), m33.result());
+  }
+}
+
+
+void test_rolling_median_spread() {
+  RollingMedian<fix16_t, 8> m;
+
+  // Window is 1..8 after shift, quartiles are 2.5 & 6.5
+  for (int i = 0; i < 8; i++) m.add(F16(50));
+  for (int i = 1; i <= 8; i++) m.add(F16(i));
+
+  TEST_ASSERT_EQUAL(F16(4), m.spread());
+}
+
+
+void test_rolling_median_float() {
+  RollingMedian<float, 3> m;
+
+  m.add(0.1F);
+  m.add(0.9F);
+  m.add(0.5F);
+  m.add(0.2F);
+
+  // Window: 0.9, 0.5, 0.2
+  TEST_ASSERT_EQUAL_FLOAT(0.5F, m.result());
+}
+
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_rolling_median_empty);
+  RUN_TEST(test_rolling_median_fill);
+  RUN_TEST(test_rolling_median_window);
+  RUN_TEST(test_rolling_median_random);
+  RUN_TEST(test_rolling_median_spread);
+  RUN_TEST(test_rolling_median_float);
+  UNITY_END();
+}
+
+
+#endif
@@ -0,0 +1,213 @@
+#ifdef UNIT_TEST
+
+#include <unity.h>
+
+#include "../src/sensors.h"
+#include "../motor_sim.h"
+
+static Sensors sensors;
+static MotorSimHalfWave hw;
+static uint16_t buf[ADC_FETCH_PER_TICK * ADC_CHANNELS_COUNT];
+
+// Feed one mains period (positive half-wave from sim + negative one) and
+// call `check()` after each speed update (or live speed refresh)
+template <typename F>
+static void feed_period(const MotorSimParams &p, F check)
+{
+  motor_sim_half_wave(p, hw);
+
+  for (int t = 0; t < hw.ticks * 2; t++)
+  {
+    bool positive = t < hw.ticks;
+
+    for (int k = 0; k < ADC_FETCH_PER_TICK; k++)
+    {
+      buf[k * 4] = positive ? hw.voltage[t] : 0;
+      buf[k * 4 + 1] = positive ? hw.current[t] : 0;
+      buf[k * 4 + 2] = 0;
+      buf[k * 4 + 3] = 1489;
+    }
+
+    sensors.in_triac_on = positive && hw.triac_on[t];
+    sensors.adc_raw_data_load(buf, 0);
+    sensors.tick();
+
+    if (sensors.speed_updated || sensors.speed_live_confident) check();
+  }
+}
+
+
+void test_sensors_late_firing_is_not_zero_speed() {
+  eeprom_float_init();
+  sensors.configure();
+
+  MotorSimParams p;
+  p.noise = 2;
+  p.fire_phase = 0;
+
+  int valid_updates = 0;
+
+  for (int i = 0; i < 20; i++) feed_period(p, [&]() {
+    if (sensors.speed_valid) valid_updates++;
+  });
+
+  TEST_ASSERT_GREATER_THAN(0, valid_updates);
+
+  // Triac opens near the end of half-wave, current rises too little for
+  // samples to pass gates. That's not a stopped motor.
+  p.fire_phase = 0.93F;
+
+  int zero_valid_updates = 0;
+
+  for (int i = 0; i < 20; i++) feed_period(p, [&]() {
+    if (sensors.speed_valid && sensors.speed == 0) zero_valid_updates++;
+  });
+
+  TEST_ASSERT_EQUAL(0, zero_valid_updates);
+}
+
+
+void test_sensors_no_firing_drops_speed() {
+  eeprom_float_init();
+  sensors.configure();
+
+  MotorSimParams p;
+  p.noise = 2;
+  p.fire_phase = 0;
+
+  for (int i = 0; i < 20; i++) feed_period(p, []() {});
+
+  // Triac is not opened at all => result is accepted as is
+  p.fire_phase = 1;
+
+  for (int i = 0; i < 5; i++) feed_period(p, []() {});
+
+  TEST_ASSERT_TRUE(sensors.speed_valid);
+#if SPEED_ESTIMATOR == SPEED_ESTIMATOR_MEDIAN && !SPEED_OBSERVER
+  // Median has no data => zero. Other estimators keep last value, observer
+  // decays smoothly.
+  TEST_ASSERT_EQUAL(0, sensors.speed);
+#endif
+}
+
+
+void test_sensors_spread_gate_works_in_calibration_units() {
+  eeprom_float_init();
+  sensors.configure();
+
+  // As in speed scale calibration - samples are R_ekv, in ohms
+  sensors.set_rekv_to_speed_factor(fix16_one);
+  sensors.cfg_speed_table.reset();
+
+  MotorSimParams p;
+  p.noise = 2;
+  p.fire_phase = 0;
+
+  int updates = 0;
+  int valid_updates = 0;
+  int confident_live = 0;
+
+  for (int i = 0; i < 20; i++) feed_period(p, [&]() {
+    if (sensors.speed_live_confident) { confident_live++; return; }
+    updates++;
+    if (sensors.speed_valid) valid_updates++;
+  });
+
+  TEST_ASSERT_EQUAL(updates, valid_updates);
+#if !SPEED_OBSERVER
+  // Live speed is disabled with observer
+  TEST_ASSERT_GREATER_THAN(0, confident_live);
+#endif
+  // Speed is updated, in ohms (observer & model fit converge slower, don't
+  // check exact value)
+  TEST_ASSERT_TRUE(sensors.speed > F16(150));
+}
+
+
+#if SPEED_ESTIMATOR == SPEED_ESTIMATOR_MEDIAN
+// Other estimators have no spread to check
+void test_sensors_noisy_live_speed_is_not_confident() {
+  eeprom_float_init();
+  sensors.configure();
+
+  // Noise is much bigger than speed => spread check fails
+  MotorSimParams p;
+  p.noise = 200;
+  p.fire_phase = 0;
+
+  int confident_live = 0;
+
+  for (int i = 0; i < 20; i++) feed_period(p, [&]() {
+    if (sensors.speed_live_confident) confident_live++;
+  });
+
+  TEST_ASSERT_EQUAL(0, confident_live);
+  TEST_ASSERT_FALSE(sensors.speed_valid);
+}
+#endif
+
+
+void test_sensors_speed_updated_once_per_period() {
+  eeprom_float_init();
+  sensors.configure();
+
+  MotorSimParams p;
+  p.noise = 2;
+  p.fire_phase = 0;
+
+  for (int i = 0; i < 5; i++) feed_period(p, []() {});
+
+  int updates = 0;
+
+  for (int i = 0; i < 10; i++) feed_period(p, [&]() {
+    if (sensors.speed_updated) updates++;
+  });
+
+  TEST_ASSERT_EQUAL(10, updates);
+}
+
+
+void test_sensors_half_wave_samples() {
+  eeprom_float_init();
+  sensors.configure();
+
+  MotorSimParams p;
+  p.noise = 2;
+  p.fire_phase = 0;
+
+  for (int i = 0; i < 5; i++) feed_period(p, []() {});
+
+  // Window is one half-wave
+  TEST_ASSERT_GREATER_THAN(0, sensors.half_wave_samples);
+  TEST_ASSERT_EQUAL(sensors.speed_samples, sensors.half_wave_samples);
+
+  // Late opening => window spans several half-waves, count is per
+  // half-wave
+  p.fire_phase = 0.9F;
+
+  int max_half_wave = 0;
+
+  for (int i = 0; i < 10; i++) feed_period(p, [&]() {
+    if (sensors.half_wave_samples > max_half_wave) max_half_wave = sensors.half_wave_samples;
+  });
+
+  TEST_ASSERT_GREATER_THAN(0, max_half_wave);
+  TEST_ASSERT_TRUE(max_half_wave < SPEED_WINDOW_MIN_SAMPLES);
+  TEST_ASSERT_TRUE(sensors.speed_samples >= SPEED_WINDOW_MIN_SAMPLES);
+}
+
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_sensors_late_firing_is_not_zero_speed);
+  RUN_TEST(test_sensors_no_firing_drops_speed);
+  RUN_TEST(test_sensors_speed_updated_once_per_period);
+  RUN_TEST(test_sensors_half_wave_samples);
+  RUN_TEST(test_sensors_spread_gate_works_in_calibration_units);
+#if SPEED_ESTIMATOR == SPEED_ESTIMATOR_MEDIAN
+  RUN_TEST(test_sensors_noisy_live_speed_is_not_confident);
+#endif
+  UNITY_END();
+}
+
+#endif
@@ -0,0 +1,79 @@
+#ifdef UNIT_TEST
+
+#include <unity.h>
+
+#include "../src/sg_derivative.h"
+
+
+void test_sg_norm() {
+  TEST_ASSERT_EQUAL((SGDerivative<int, 3>::NORM), 2);
+  TEST_ASSERT_EQUAL((SGDerivative<int, 5>::NORM), 10);
+  TEST_ASSERT_EQUAL((SGDerivative<int, 7>::NORM), 28);
+  TEST_ASSERT_EQUAL((SGDerivative<int, 9>::NORM), 60);
+}
+
+
+void test_sg_ramp() {
+  SGDerivative<int, 5> d;
+
+  // x = 3 * t + 100
+  for (int t = 0; t < 20; t++) d.add(3 * t + 100);
+
+  TEST_ASSERT_EQUAL(d.result(), 3 * d.NORM);
+  // Middle of last 5 samples, t = 17
+  TEST_ASSERT_EQUAL(d.center(), 3 * 17 + 100);
+}
+
+
+void test_sg_parabola() {
+  SGDerivative<int, 7> d;
+
+  // x = t^2, derivative at middle sample is exact
+  for (int t = 0; t < 10; t++) d.add(t * t);
+
+  // Window is t = 3..9, middle t = 6
+  TEST_ASSERT_EQUAL(d.result(), 2 * 6 * d.NORM);
+}
+
+
+void test_sg_noise() {
+  SGDerivative<int, 5> d;
+  uint32_t rand_state = 1;
+  int prev = 0;
+  double sg_sq = 0;
+  double diff_sq = 0;
+  const int n = 10000;
+
+  for (int t = 0; t < n; t++)
+  {
+    rand_state = rand_state * 1103515245 + 12345;
+    int val = 1000 + (int)((rand_state >> 16) % 9) - 4;
+
+    d.add(val);
+
+    if (t >= 5)
+    {
+      double sg = (double)d.result() / d.NORM;
+      sg_sq += sg * sg;
+      diff_sq += (double)(val - prev) * (val - prev);
+    }
+
+    prev = val;
+  }
+
+  // Variance should drop 2 * NORM times (20x)
+  TEST_ASSERT_FLOAT_WITHIN(2, 2 * d.NORM, diff_sq / sg_sq);
+}
+
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_sg_norm);
+  RUN_TEST(test_sg_ramp);
+  RUN_TEST(test_sg_parabola);
+  RUN_TEST(test_sg_noise);
+  UNITY_END();
+}
+
+
+#endif
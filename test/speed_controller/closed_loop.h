@@ -0,0 +1,66 @@
+#ifndef __TEST_CLOSED_LOOP__
+#define __TEST_CLOSED_LOOP__
+
+// Closed loop with simple motor model:
+//
+// - 1st order, time constant 0.3s, steady speed = power - load
+// - speed is measured once per mains period, as Sensors do, and
+//   `in_speed_updated` is set on those ticks
+
+#include <math.h>
+
+#include "../src/app.h"
+#include "../src/config_map.h"
+#include "../src/fix16_math/fix16_math.h"
+
+#define MOTOR_TIME_CONSTANT 0.3
+
+struct LoopResult
+{
+  // Time (s) to get within 1% of target & stay there, -1 if never
+  float settle_time;
+  // Abs speed error at the end
+  float steady_error;
+};
+
+template <typename Controller>
+static LoopResult run_loop(Controller &controller, fix16_t knob, float load,
+  int mains_freq, float seconds)
+{
+  float speed = 0;
+  int ticks = seconds * APP_TICK_FREQUENCY;
+  int period = APP_TICK_FREQUENCY / mains_freq;
+  int settled_at = -1;
+
+  controller.configure();
+  controller.in_knob = knob;
+
+  // Same knob normalization in all versions: dead zone, then rescale to
+  // [min..max] limits
+  float dead_zone = CFG_DEAD_ZONE_WIDTH_DEFAULT / 100;
+  float min = CFG_RPM_MIN_LIMIT_DEFAULT / CFG_RPM_MAX_DEFAULT;
+  float max = CFG_RPM_MAX_LIMIT_DEFAULT / CFG_RPM_MAX_DEFAULT;
+  float target = (fix16_to_float(knob) - dead_zone) * (max - min) / (1 - dead_zone) + min;
+
+  for (int i = 0; i < ticks; i++)
+  {
+    controller.in_speed_updated = (i % period == 0);
+
+    if (controller.in_speed_updated) controller.in_speed = fix16_from_float(speed);
+
+    controller.tick();
+
+    float power = fix16_to_float(controller.out_power);
+    speed += (power - load - speed) / (MOTOR_TIME_CONSTANT * APP_TICK_FREQUENCY);
+
+    if (fabsf(speed - target) > 0.01) settled_at = -1;
+    else if (settled_at < 0) settled_at = i;
+  }
+
+  LoopResult result;
+  result.settle_time = settled_at < 0 ? -1 : (float)settled_at / APP_TICK_FREQUENCY;
+  result.steady_error = fabsf(speed - target);
+  return result;
+}
+
+#endif
@@ -0,0 +1,111 @@
+#ifndef __TEST_SPEED_CONTROLLER_LEGACY__
+#define __TEST_SPEED_CONTROLLER_LEGACY__
+
+// Previous SpeedController implementation (fix16 integrator, 40Hz), with PID
+// rate as template parameter. Speed PID only (limiter was not implemented).
+// Kept for comparison only.
+
+#include "../src/app.h"
+#include "../src/eeprom_float.h"
+#include "../src/config_map.h"
+#include "../src/fix16_math/fix16_math.h"
+
+template <int PID_FREQUENCY>
+class SpeedControllerLegacy
+{
+public:
+  fix16_t in_knob = 0;
+  fix16_t in_speed = 0;
+  bool in_speed_valid = true;
+  bool in_speed_updated = false; // Not used, to share test loop
+
+  fix16_t out_power = 0;
+
+  void tick()
+  {
+    if (tick_freq_divide_counter >= APP_TICK_FREQUENCY / PID_FREQUENCY) tick_freq_divide_counter = 0;
+
+    if (tick_freq_divide_counter > 0) {
+      tick_freq_divide_counter++;
+      return;
+    }
+
+    tick_freq_divide_counter++;
+
+    knob_normalized = normalize_knob(in_knob);
+
+    if (in_speed_valid) out_power = speed_pid_tick();
+  }
+
+  void configure()
+  {
+    cfg_dead_zone_width_norm = fix16_from_float(eeprom_float_read(CFG_DEAD_ZONE_WIDTH_ADDR,
+       CFG_DEAD_ZONE_WIDTH_DEFAULT) / 100.0F);
+
+    cfg_pid_p = fix16_from_float(eeprom_float_read(CFG_PID_P_ADDR,
+       CFG_PID_P_DEFAULT));
+
+    cfg_pid_i_inv = fix16_from_float(
+      1.0F
+      / eeprom_float_read(CFG_PID_I_ADDR, CFG_PID_I_DEFAULT)
+      / PID_FREQUENCY
+    );
+
+    float _rpm_max = eeprom_float_read(CFG_RPM_MAX_ADDR, CFG_RPM_MAX_DEFAULT);
+
+    cfg_rpm_max_limit_norm = fix16_from_float(
+      eeprom_float_read(CFG_RPM_MAX_LIMIT_ADDR, CFG_RPM_MAX_LIMIT_DEFAULT) / _rpm_max
+    );
+
+    cfg_rpm_min_limit_norm = fix16_from_float(
+      eeprom_float_read(CFG_RPM_MIN_LIMIT_ADDR, CFG_RPM_MIN_LIMIT_DEFAULT) / _rpm_max
+    );
+
+    knob_norm_coeff =  fix16_div(
+      cfg_rpm_max_limit_norm - cfg_rpm_min_limit_norm,
+      fix16_one - cfg_dead_zone_width_norm
+    );
+  }
+
+private:
+  fix16_t cfg_dead_zone_width_norm;
+  fix16_t cfg_pid_p;
+  fix16_t cfg_pid_i_inv;
+  fix16_t cfg_rpm_max_limit_norm;
+  fix16_t cfg_rpm_min_limit_norm;
+
+  fix16_t knob_norm_coeff = F16(1);
+  fix16_t knob_normalized;
+
+  fix16_t pid_speed_integral = 0;
+
+  uint32_t tick_freq_divide_counter = 0;
+
+  fix16_t normalize_knob(fix16_t knob)
+  {
+    if (in_knob < cfg_dead_zone_width_norm) return 0;
+
+    return fix16_mul(
+      (in_knob - cfg_dead_zone_width_norm),
+      knob_norm_coeff
+    ) + cfg_rpm_min_limit_norm;
+  }
+
+  fix16_t speed_pid_tick()
+  {
+    fix16_t divergence = knob_normalized - in_speed;
+
+    fix16_t tmp = pid_speed_integral + fix16_mul(cfg_pid_i_inv, divergence);
+    pid_speed_integral = fix16_clamp(tmp, cfg_rpm_min_limit_norm, cfg_rpm_max_limit_norm);
+
+    fix16_t proportional = fix16_mul(cfg_pid_p, divergence);
+
+    return fix16_clamp(
+      proportional + pid_speed_integral,
+      cfg_rpm_min_limit_norm,
+      cfg_rpm_max_limit_norm
+    );
+  }
+};
+
+#endif
@@ -0,0 +1,63 @@
+#ifdef UNIT_TEST
+
+#include <unity.h>
+#include <math.h>
+
+#include "../src/speed_controller.h"
+#include "speed_controller_legacy.h"
+#include "closed_loop.h"
+
+void test_controller_steady_state() {
+  SpeedController controller;
+  SpeedControllerLegacy<40> legacy;
+  SpeedControllerLegacy<APP_PID_FREQUENCY> legacy_fast;
+
+  LoopResult r = run_loop(controller, F16(0.5), 0.1, 50, 60);
+  LoopResult r_legacy = run_loop(legacy, F16(0.5), 0.1, 50, 60);
+  LoopResult r_legacy_fast = run_loop(legacy_fast, F16(0.5), 0.1, 50, 60);
+
+  printf("  error: %.5f (legacy 40Hz %.5f, legacy %dHz %.5f)\n", r.steady_error,
+    r_legacy.steady_error, APP_PID_FREQUENCY, r_legacy_fast.steady_error);
+
+  // fix16 integrator stops, when increment becomes zero. At higher rate
+  // Ki is smaller and error left is bigger.
+  TEST_ASSERT_TRUE(r_legacy_fast.steady_error > r_legacy.steady_error);
+  TEST_ASSERT_TRUE(r.steady_error < 0.0001);
+  TEST_ASSERT_EQUAL(0, fixed_overflow_count());
+}
+
+
+void test_controller_settles_faster() {
+  // Tuned for faster response
+  eeprom_float_write(CFG_PID_P_ADDR, 2.0);
+  eeprom_float_write(CFG_PID_I_ADDR, 0.2);
+
+  SpeedController controller;
+  SpeedControllerLegacy<40> legacy;
+
+  LoopResult r = run_loop(controller, F16(0.5), 0.1, 50, 10);
+  LoopResult r_legacy = run_loop(legacy, F16(0.5), 0.1, 50, 10);
+
+  printf("  settle: %.3fs (legacy 40Hz %.3fs)\n", r.settle_time, r_legacy.settle_time);
+
+  TEST_ASSERT_TRUE(r.settle_time > 0);
+  TEST_ASSERT_TRUE(r.settle_time < r_legacy.settle_time * 0.95);
+  TEST_ASSERT_TRUE(r.steady_error < 0.0001);
+
+  // Restore defaults
+  eeprom_float_write(CFG_PID_P_ADDR, CFG_PID_P_DEFAULT);
+  eeprom_float_write(CFG_PID_I_ADDR, CFG_PID_I_DEFAULT);
+}
+
+
+int main() {
+  eeprom_float_init();
+
+  UNITY_BEGIN();
+  RUN_TEST(test_controller_steady_state);
+  RUN_TEST(test_controller_settles_faster);
+  UNITY_END();
+}
+
+
+#endif
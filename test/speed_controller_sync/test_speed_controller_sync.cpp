@@ -0,0 +1,181 @@
+#ifdef UNIT_TEST
+
+#include <unity.h>
+#include <math.h>
+
+// Build controller in event-synchronous mode
+#define SPEED_PID_SYNC 1
+
+#include "../src/speed_controller.h"
+#include "../speed_controller/speed_controller_legacy.h"
+#include "../speed_controller/closed_loop.h"
+
+
+void test_sync_runs_on_speed_update_only() {
+  SpeedController controller;
+
+  controller.configure();
+  controller.in_knob = F16(0.5);
+
+  for (int i = 0; i < 1000; i++) controller.tick();
+
+  // No speed updates => output not changed
+  TEST_ASSERT_EQUAL(0, controller.out_power);
+
+  controller.in_speed_updated = true;
+  controller.tick();
+
+  TEST_ASSERT_TRUE(controller.out_power > 0);
+}
+
+
+void test_sync_steady_state() {
+  SpeedController controller;
+
+  LoopResult r = run_loop(controller, F16(0.5), 0.1, 50, 60);
+
+  TEST_ASSERT_TRUE(r.steady_error < 0.0001);
+  TEST_ASSERT_EQUAL(0, fixed_overflow_count());
+}
+
+
+// Ticks from speed update to output change
+template <typename Controller>
+static int reaction_delay(Controller &controller, int phase)
+{
+  controller.configure();
+  controller.in_knob = F16(0.5);
+  controller.in_speed = F16(0.3);
+
+  for (int i = 0; i < phase; i++) controller.tick();
+
+  fix16_t power = controller.out_power;
+
+  controller.in_speed = F16(0.4);
+  controller.in_speed_updated = true;
+
+  for (int i = 0; i < APP_TICK_FREQUENCY; i++)
+  {
+    controller.tick();
+    controller.in_speed_updated = false;
+
+    if (controller.out_power != power) return i;
+  }
+  return -1;
+}
+
+void test_sync_no_stale_data() {
+  int max_delay = 0;
+  int max_delay_legacy = 0;
+
+  // Free running PID sees new data with random delay, depending on phase
+  for (int phase = 0; phase < 500; phase += 7)
+  {
+    SpeedController controller;
+    SpeedControllerLegacy<APP_PID_FREQUENCY> legacy;
+
+    int delay = reaction_delay(controller, phase);
+    int delay_legacy = reaction_delay(legacy, phase);
+
+    if (delay > max_delay) max_delay = delay;
+    if (delay_legacy > max_delay_legacy) max_delay_legacy = delay_legacy;
+  }
+
+  printf("  max delay: %d ticks (free running %dHz %d ticks)\n",
+    max_delay, APP_PID_FREQUENCY, max_delay_legacy);
+
+  TEST_ASSERT_EQUAL(0, max_delay);
+  TEST_ASSERT_TRUE(max_delay_legacy > APP_TICK_FREQUENCY / APP_PID_FREQUENCY / 2);
+}
+
+
+void test_sync_integrator_scaled_by_time() {
+  // Integrator is scaled by real interval => the same dynamics with
+  // different update rates
+  SpeedController controller_50;
+  SpeedController controller_60;
+
+  LoopResult r_50 = run_loop(controller_50, F16(0.5), 0.1, 50, 30);
+  LoopResult r_60 = run_loop(controller_60, F16(0.5), 0.1, 60, 30);
+
+  printf("  settle: 50Hz %.3fs, 60Hz %.3fs\n", r_50.settle_time, r_60.settle_time);
+
+  TEST_ASSERT_FLOAT_WITHIN(r_50.settle_time * 0.05, r_50.settle_time, r_60.settle_time);
+}
+
+
+void test_sync_settles_not_slower_than_fixed_rate() {
+  // Tuned for faster response
+  eeprom_float_write(CFG_PID_P_ADDR, 2.0);
+  eeprom_float_write(CFG_PID_I_ADDR, 0.2);
+
+  for (int mains_freq = 50; mains_freq <= 60; mains_freq += 10)
+  {
+    SpeedController controller;
+    SpeedControllerLegacy<APP_PID_FREQUENCY> fixed_rate;
+
+    LoopResult r = run_loop(controller, F16(0.5), 0.1, mains_freq, 10);
+    LoopResult r_fixed = run_loop(fixed_rate, F16(0.5), 0.1, mains_freq, 10);
+
+    printf("  settle %dHz: %.3fs (fixed rate %dHz %.3fs)\n", mains_freq,
+      r.settle_time, APP_PID_FREQUENCY, r_fixed.settle_time);
+
+    TEST_ASSERT_TRUE(r.settle_time > 0);
+    TEST_ASSERT_TRUE(r.settle_time <= r_fixed.settle_time);
+  }
+
+  // Restore defaults
+  eeprom_float_write(CFG_PID_P_ADDR, CFG_PID_P_DEFAULT);
+  eeprom_float_write(CFG_PID_I_ADDR, CFG_PID_I_DEFAULT);
+}
+
+
+// Integrate constant divergence, marking some updates invalid
+static fix16_t integrate(SpeedController &controller, int invalid_every)
+{
+  controller.configure();
+  controller.in_knob = F16(0.5);
+  controller.in_speed = F16(0.4);
+
+  // 0.2s, 10 updates
+  for (int i = 1; i <= APP_TICK_FREQUENCY / 5; i++)
+  {
+    int update = i / (APP_TICK_FREQUENCY / 50);
+
+    controller.in_speed_updated = (i % (APP_TICK_FREQUENCY / 50) == 0);
+    controller.in_speed_valid = !invalid_every || (update % invalid_every);
+    controller.tick();
+  }
+
+  return controller.out_power;
+}
+
+void test_sync_invalid_updates_keep_time() {
+  SpeedController controller;
+  SpeedController controller_skips;
+
+  fix16_t power = integrate(controller, 0);
+  // Every 2nd update is invalid. Last one (10) is valid.
+  fix16_t power_skips = integrate(controller_skips, 2);
+
+  // Not saturated
+  TEST_ASSERT_TRUE(power < F16(0.9));
+  TEST_ASSERT_INT_WITHIN(F16(0.001), power, power_skips);
+}
+
+
+int main() {
+  eeprom_float_init();
+
+  UNITY_BEGIN();
+  RUN_TEST(test_sync_runs_on_speed_update_only);
+  RUN_TEST(test_sync_steady_state);
+  RUN_TEST(test_sync_no_stale_data);
+  RUN_TEST(test_sync_integrator_scaled_by_time);
+  RUN_TEST(test_sync_settles_not_slower_than_fixed_rate);
+  RUN_TEST(test_sync_invalid_updates_keep_time);
+  UNITY_END();
+}
+
+
+#endif
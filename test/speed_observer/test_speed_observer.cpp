@@ -0,0 +1,141 @@
+#ifdef UNIT_TEST
+
+#include <unity.h>
+#include <math.h>
+
+#include "../src/fix16_math/fix16_math.h"
+#include "../src/speed_observer.h"
+
+// Updates per second (once per 50Hz mains period)
+#define UPDATE_FREQ 50
+#define UPDATE_TICKS (APP_TICK_FREQUENCY / UPDATE_FREQ)
+
+static uint32_t rand_state = 1;
+
+// Uniform noise in [-amplitude..amplitude]
+static float noise(float amplitude)
+{
+  rand_state = rand_state * 1103515245 + 12345;
+  return ((float)((rand_state >> 16) & 0x7FFF) / 0x7FFF * 2 - 1) * amplitude;
+}
+
+
+void test_observer_converges_with_load() {
+  SpeedObserver observer;
+  observer.configure(0.3);
+
+  // Loaded motor runs slower than model expects
+  for (int i = 0; i < 10 * UPDATE_FREQ; i++) observer.update(F16(0.8), F16(0.6), UPDATE_TICKS);
+
+  TEST_ASSERT_FLOAT_WITHIN(0.01, 0.6, fix16_to_float(observer.speed));
+  TEST_ASSERT_FLOAT_WITHIN(0.01, -0.2, fix16_to_float(observer.offset));
+}
+
+
+void test_observer_reduces_noise() {
+  SpeedObserver observer;
+  observer.configure(0.3);
+
+  for (int i = 0; i < 5 * UPDATE_FREQ; i++) observer.update(F16(0.5), F16(0.5), UPDATE_TICKS);
+
+  float raw_sq = 0;
+  float est_sq = 0;
+  const int n = 10 * UPDATE_FREQ;
+
+  for (int i = 0; i < n; i++)
+  {
+    float z = 0.5 + noise(0.1);
+    float est = fix16_to_float(observer.update(F16(0.5), fix16_from_float(z), UPDATE_TICKS));
+
+    raw_sq += (z - 0.5) * (z - 0.5);
+    est_sq += (est - 0.5) * (est - 0.5);
+  }
+
+  // RMS error should drop at least 2x
+  TEST_ASSERT_LESS_THAN(sqrtf(raw_sq / n) / 2, sqrtf(est_sq / n));
+}
+
+
+void test_observer_follows_power_step() {
+  SpeedObserver observer;
+  observer.configure(0.3);
+
+  for (int i = 0; i < 5 * UPDATE_FREQ; i++) observer.update(F16(0.3), F16(0.3), UPDATE_TICKS);
+
+  // Emulate real motor with the same time constant
+  float real = 0.3;
+  int settled_at = -1;
+
+  for (int i = 0; i < 2 * UPDATE_FREQ; i++)
+  {
+    real += (0.9 - real) / (0.3 * UPDATE_FREQ);
+    float est = fix16_to_float(observer.update(F16(0.9), fix16_from_float(real), UPDATE_TICKS));
+
+    if (settled_at < 0 && fabsf(est - real) < 0.01) settled_at = i;
+  }
+
+  // Model predicts acceleration, observer should not lag
+  TEST_ASSERT_TRUE(settled_at >= 0 && settled_at < 5);
+}
+
+
+// Max estimation error after power step, with exact motor response
+static float step_tracking_error(int update_freq, int ticks)
+{
+  SpeedObserver observer;
+  observer.configure(0.3);
+
+  for (int i = 0; i < 5 * update_freq; i++) observer.update(F16(0.3), F16(0.3), ticks);
+
+  float max_error = 0;
+
+  for (int i = 1; i < update_freq; i++)
+  {
+    float real = 0.9 - 0.6 * expf(-(float)i / update_freq / 0.3);
+    float est = fix16_to_float(observer.update(F16(0.9), fix16_from_float(real), ticks));
+
+    max_error = fmaxf(max_error, fabsf(est - real));
+  }
+
+  return max_error;
+}
+
+void test_observer_model_uses_elapsed_time() {
+  // 60Hz mains, model steps by real time
+  float error = step_tracking_error(60, APP_TICK_FREQUENCY / 60);
+  // The same, if step is fixed for 50Hz
+  float error_fixed = step_tracking_error(60, APP_TICK_FREQUENCY / 50);
+
+  TEST_ASSERT_TRUE(error < 0.01);
+  TEST_ASSERT_TRUE(error < error_fixed / 2);
+}
+
+
+void test_observer_predict_ignores_stale_measurement() {
+  SpeedObserver observer;
+  observer.configure(0.3);
+
+  for (int i = 0; i < 5 * UPDATE_FREQ; i++) observer.update(F16(0.3), F16(0.3), UPDATE_TICKS);
+
+  // Power step, measurements are lost for 0.2 sec. Model should follow
+  // acceleration alone, no pull to old speed.
+  for (int i = 0; i < UPDATE_FREQ / 5; i++) observer.predict(F16(0.9), UPDATE_TICKS);
+
+  float real = 0.9 - 0.6 * expf(-0.2 / 0.3);
+
+  TEST_ASSERT_FLOAT_WITHIN(0.01, real, fix16_to_float(observer.speed));
+}
+
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_observer_converges_with_load);
+  RUN_TEST(test_observer_reduces_noise);
+  RUN_TEST(test_observer_follows_power_step);
+  RUN_TEST(test_observer_model_uses_elapsed_time);
+  RUN_TEST(test_observer_predict_ignores_stale_measurement);
+  UNITY_END();
+}
+
+
+#endif
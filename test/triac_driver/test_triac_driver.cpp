@@ -0,0 +1,211 @@
+#ifdef UNIT_TEST
+
+#include <unity.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include "../src/fix16_math/fix16_math.h"
+#include "../src/triac_driver.h"
+
+
+// Previous implementation, with threshold calculated on every tick. Load
+// angle is taken from tested driver.
+class TriacDriverReference
+{
+public:
+  fix16_t setpoint = 0;
+  fix16_t load_angle = 0;
+  bool triac_on = false;
+
+  void tick(bool zero_cross_up, bool zero_cross_down)
+  {
+    if (zero_cross_up || zero_cross_down)
+    {
+      if (once_zero_crossed) once_period_counted = true;
+      once_zero_crossed = true;
+
+      if (once_period_counted && zero_cross_down) positive_period_in_ticks = phase_counter;
+
+      phase_counter = 0;
+      triac_open_done = false;
+      triac_on = false;
+    }
+
+    if (!once_period_counted)
+    {
+      phase_counter++;
+      return;
+    }
+
+    if (!triac_open_done) {
+#if TRIAC_RL_COMPENSATION
+      fix16_t normalized_setpoint = triac_phase(setpoint, load_angle);
+#else
+      fix16_t normalized_setpoint = fix16_sinusize(setpoint);
+#endif
+
+      uint32_t ticks_threshold = fix16_to_int(
+        (fix16_one - normalized_setpoint) * positive_period_in_ticks
+      );
+
+      if ((phase_counter >= ticks_threshold) &&
+          (phase_counter + TRIAC_ZERO_TAIL_LENGTH < positive_period_in_ticks)) {
+        triac_open_done = true;
+        triac_on = true;
+      }
+    }
+
+    phase_counter++;
+  }
+
+private:
+  uint32_t phase_counter = 0;
+  bool triac_open_done = false;
+  uint32_t positive_period_in_ticks = 0;
+  bool once_zero_crossed = false;
+  bool once_period_counted = false;
+};
+
+
+// Runs both drivers on sequence of half-waves with given length. Returns
+// number of ticks with different triac state.
+static int compare_drivers(int min_period, int max_period, int setpoint_change_chance)
+{
+  Sensors sensors;
+  TriacDriver driver(sensors);
+  TriacDriverReference reference;
+
+  sensors.configure();
+
+  int mismatches = 0;
+  bool positive = true;
+
+  for (int wave = 0; wave < 2000; wave++)
+  {
+    int period = min_period + rand() % (max_period - min_period + 1);
+
+    // Load angle depends on speed
+    sensors.speed = rand() % (fix16_one + 1);
+
+    for (int i = 0; i < period; i++)
+    {
+      if (rand() % 1000 < setpoint_change_chance)
+      {
+        fix16_t setpoint = rand() % (fix16_one + 1);
+        driver.setpoint = setpoint;
+        reference.setpoint = setpoint;
+      }
+
+      sensors.zero_cross_up = (i == 0) && positive;
+      sensors.zero_cross_down = (i == 0) && !positive;
+
+      driver.tick();
+      reference.load_angle = driver.load_angle;
+      reference.tick(sensors.zero_cross_up, sensors.zero_cross_down);
+
+      if (sensors.in_triac_on != reference.triac_on) mismatches++;
+    }
+
+    positive = !positive;
+  }
+
+  return mismatches;
+}
+
+
+void test_triac_driver_fixed_period() {
+  srand(1);
+  TEST_ASSERT_EQUAL_INT(0, compare_drivers(178, 178, 10));
+}
+
+void test_triac_driver_drifting_period() {
+  srand(2);
+  TEST_ASSERT_EQUAL_INT(0, compare_drivers(100, 200, 10));
+}
+
+void test_triac_driver_frequent_setpoint_change() {
+  srand(3);
+  TEST_ASSERT_EQUAL_INT(0, compare_drivers(170, 186, 500));
+}
+
+void test_triac_driver_setpoint_sweep() {
+  // Fire tick for all setpoints, with the same period
+  for (fix16_t setpoint = 0; setpoint <= fix16_one; setpoint += fix16_one / 256)
+  {
+    Sensors sensors;
+    TriacDriver driver(sensors);
+    TriacDriverReference reference;
+
+    sensors.configure();
+    driver.setpoint = setpoint;
+    reference.setpoint = setpoint;
+
+    for (int wave = 0; wave < 6; wave++)
+    {
+      for (int i = 0; i < 178; i++)
+      {
+        sensors.zero_cross_up = (i == 0) && !(wave & 1);
+        sensors.zero_cross_down = (i == 0) && (wave & 1);
+
+        driver.tick();
+        reference.load_angle = driver.load_angle;
+        reference.tick(sensors.zero_cross_up, sensors.zero_cross_down);
+
+        TEST_ASSERT_EQUAL(reference.triac_on, sensors.in_triac_on);
+      }
+    }
+  }
+}
+
+
+#if TRIAC_RL_COMPENSATION
+void test_triac_driver_load_angle_uses_linear_speed() {
+  Sensors sensors;
+  TriacDriver driver(sensors);
+
+  sensors.configure();
+
+  // Calibrated curve is not identity: speed = sqrt(linear speed)
+  for (int i = 0; i < sensors.cfg_speed_table.SIZE; i++)
+  {
+    sensors.cfg_speed_table.table[i] =
+      fix16_sqrt(fix16_one * i / (sensors.cfg_speed_table.SIZE - 1));
+  }
+
+  // Linear speed 0.25
+  sensors.speed = F16(0.5);
+
+  for (int wave = 0; wave < 6; wave++)
+  {
+    for (int i = 0; i < 178; i++)
+    {
+      sensors.zero_cross_up = (i == 0) && !(wave & 1);
+      sensors.zero_cross_down = (i == 0) && (wave & 1);
+      driver.tick();
+    }
+  }
+
+  float w = 3.14159265F * APP_TICK_FREQUENCY / 178;
+  float r_ekv = 0.25F * fix16_to_float(sensors.cfg_rekv_to_speed_factor);
+  float expected = atan2f(w * fix16_to_float(sensors.cfg_motor_inductance),
+    fix16_to_float(sensors.cfg_motor_resistance) + r_ekv);
+
+  TEST_ASSERT_FLOAT_WITHIN(0.01, expected, fix16_to_float(driver.load_angle));
+}
+#endif
+
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_triac_driver_fixed_period);
+  RUN_TEST(test_triac_driver_drifting_period);
+  RUN_TEST(test_triac_driver_frequent_setpoint_change);
+  RUN_TEST(test_triac_driver_setpoint_sweep);
+#if TRIAC_RL_COMPENSATION
+  RUN_TEST(test_triac_driver_load_angle_uses_linear_speed);
+#endif
+  UNITY_END();
+}
+
+
+#endif
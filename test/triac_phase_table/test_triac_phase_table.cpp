@@ -0,0 +1,165 @@
+#ifdef UNIT_TEST
+
+#include <unity.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include "../src/fix16_math/fix16_math.h"
+#include "../src/triac_phase_table.h"
+
+
+// Energy for opening angle `a`, RL load with angle `phi`. Extinction angle
+// is found with bisection, independent from table generator.
+static double energy_reference(double a, double phi)
+{
+  if (a <= phi) return 1;
+  if (phi == 0) return (cos(a) + 1) / 2;
+
+  double lo = M_PI;
+  double hi = M_PI + phi;
+
+  for (int i = 0; i < 60; i++)
+  {
+    double mid = (lo + hi) / 2;
+
+    if (sin(mid - phi) > sin(a - phi) * exp(-(mid - a) / tan(phi))) lo = mid;
+    else hi = mid;
+  }
+
+  return (cos(a) - cos(lo)) / (2 * cos(phi));
+}
+
+static double phase_reference(double x, double phi)
+{
+  double lo = phi;
+  double hi = M_PI;
+
+  for (int i = 0; i < 60; i++)
+  {
+    double mid = (lo + hi) / 2;
+
+    if (energy_reference(mid, phi) > x) lo = mid;
+    else hi = mid;
+  }
+
+  return 1 - lo / M_PI;
+}
+
+
+void test_triac_phase_resistive() {
+  const auto &table = triac_phase_table<
+    TRIAC_PHASE_SETPOINT_BITS,
+    TRIAC_PHASE_ANGLE_BITS,
+    TRIAC_PHASE_ANGLE_INTERVALS
+  >;
+  const auto &sinusize = fix16_sinusize_table<TRIAC_PHASE_SETPOINT_BITS>;
+
+  // Resistive load => the same as sinusize
+  for (int i = 0; i < table.SETPOINT_SIZE; i++)
+  {
+    TEST_ASSERT_EQUAL(sinusize.data[i], table.data[0][i]);
+  }
+}
+
+
+void test_triac_phase_table() {
+  const auto &table = triac_phase_table<
+    TRIAC_PHASE_SETPOINT_BITS,
+    TRIAC_PHASE_ANGLE_BITS,
+    TRIAC_PHASE_ANGLE_INTERVALS
+  >;
+
+  for (int j = 0; j < table.ANGLE_SIZE; j++)
+  {
+    double phi = (double)j / (1 << TRIAC_PHASE_ANGLE_BITS);
+
+    for (int i = 0; i < table.SETPOINT_SIZE; i++)
+    {
+      double y = phase_reference((double)i / (table.SETPOINT_SIZE - 1), phi) * 65536;
+      if (y > 65535) y = 65535;
+
+      TEST_ASSERT_FLOAT_WITHIN(1.0, y, table.data[j][i]);
+
+      // Monotonic by setpoint
+      if (i > 0) TEST_ASSERT_TRUE(table.data[j][i] >= table.data[j][i - 1]);
+    }
+  }
+}
+
+// Table range
+#define ANGLE_MAX (TRIAC_PHASE_ANGLE_INTERVALS << (16 - TRIAC_PHASE_ANGLE_BITS))
+
+
+void test_triac_phase_precision() {
+  double max_error = 0;
+  double mid_error = 0;
+
+  srand(1);
+
+  for (int n = 0; n < 20000; n++)
+  {
+    fix16_t x = rand() % fix16_one;
+    fix16_t angle = rand() % ANGLE_MAX;
+
+    double error = fabs(fix16_to_float(triac_phase(x, angle)) -
+      phase_reference(x / 65536.0, angle / 65536.0));
+
+    if (error > max_error) max_error = error;
+    if (x >= F16(0.05) && x < F16(0.95) && error > mid_error) mid_error = error;
+  }
+
+  char msg[100];
+  snprintf(msg, sizeof(msg), "Max error, full / [0.05..0.95]: %.4f / %.4f",
+    max_error, mid_error);
+  TEST_MESSAGE(msg);
+
+  TEST_ASSERT_TRUE(max_error < 0.06);
+  TEST_ASSERT_TRUE(mid_error < 0.0025);
+}
+
+
+void test_triac_phase_limits() {
+  TEST_ASSERT_EQUAL(0, triac_phase(0, 0));
+  TEST_ASSERT_EQUAL(0, triac_phase(F16(-0.5), F16(0.5)));
+  TEST_ASSERT_TRUE(triac_phase(F16(2), F16(2)) <= 65535);
+
+  // Inductive load => full energy with opening before current lag
+  TEST_ASSERT_FLOAT_WITHIN(0.001, 1 - 0.5 / M_PI,
+    fix16_to_float(triac_phase(fix16_one - 1, F16(0.5))));
+}
+
+
+void test_triac_phase_angle_saturation() {
+  // Low resistance motor at standstill, load angle above 1 rad is real
+  // (wL / R = 3 => 1.25 rad)
+  fix16_t angle = F16(1.25);
+
+  TEST_ASSERT_FLOAT_WITHIN(0.002, phase_reference(0.5, 1.25),
+    fix16_to_float(triac_phase(F16(0.5), angle)));
+
+  // Above table range => last row
+  for (fix16_t x = 0; x < fix16_one; x += F16(0.1))
+  {
+    TEST_ASSERT_EQUAL(triac_phase(x, ANGLE_MAX - 1), triac_phase(x, F16(1.55)));
+    TEST_ASSERT_EQUAL(triac_phase(x, ANGLE_MAX - 1), triac_phase(x, F16(3)));
+  }
+
+  // PI/2 is not reachable => phase is limited by the last row
+  TEST_ASSERT_FLOAT_WITHIN(0.001, 1 - 1.5 / M_PI,
+    fix16_to_float(triac_phase(fix16_one - 1, F16(2))));
+}
+
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_triac_phase_resistive);
+  RUN_TEST(test_triac_phase_table);
+  RUN_TEST(test_triac_phase_precision);
+  RUN_TEST(test_triac_phase_limits);
+  RUN_TEST(test_triac_phase_angle_saturation);
+  UNITY_END();
+}
+
+
+#endif